@@ -0,0 +1,181 @@
+/*
+    Description:
+        Arena allocator (see arena.h).
+
+    Sources:
+        https://www.rfleury.com/p/untangling-lifetimes-the-arena-allocator
+        https://www.kernel.org/doc/html/latest/admin-guide/mm/hugetlbpage.html
+        https://www.kernel.org/doc/html/latest/admin-guide/mm/transhuge.html
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Pages ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Pages are not touched here, the first write decides on which NUMA node they land
+static ArenaBlock *createBlock(size_t size){
+    ArenaBlock *block = malloc(sizeof(*block));
+    if(block == NULL){
+        printf("\nERROR: createBlock() function => not enough memory\n");
+        exit(1);
+    }
+    block->next = NULL;
+    block->used = 0;
+    block->size = size;
+    block->kind = PAGES_HEAP;
+    block->memory = NULL;
+
+#ifdef __linux__
+    if(size >= HUGE_PAGE_SIZE){
+        size_t length = (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+        void *memory = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        block->kind = PAGES_HUGE;
+#endif
+        if(memory == MAP_FAILED){
+            // No explicit huge pages reserved: fall back on normal pages and ask for transparent huge pages
+            memory = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if(memory != MAP_FAILED){
+                madvise(memory, length, MADV_HUGEPAGE);
+            }
+#endif
+            block->kind = PAGES_MAPPED;
+        }
+        if(memory != MAP_FAILED){
+            block->memory = memory;
+            block->size = length;
+            return block;
+        }
+        block->kind = PAGES_HEAP;
+    }
+#endif
+
+    block->memory = malloc(size);
+    if(block->memory == NULL){
+        printf("\nERROR: createBlock() function => not enough memory for a block of %zu bytes\n", size);
+        exit(1);
+    }
+    return block;
+}
+
+static void destroyBlock(ArenaBlock *block){
+#ifdef __linux__
+    if(block->kind != PAGES_HEAP){
+        munmap(block->memory, block->size);
+    }
+    else
+#endif
+    {
+        free(block->memory);
+    }
+    free(block);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Arena ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+void initArena(Arena *arena, const char *name, size_t blockSize){
+    arena->name = name;
+    arena->blockSize = blockSize;
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->reserved = 0;
+    arena->hugeReserved = 0;
+    arena->allocations = 0;
+}
+
+// align must be a power of two
+void *arenaAlloc(Arena *arena, size_t size, size_t align){
+    ArenaBlock *block = arena->current;
+
+    while(1){
+        if(block != NULL){
+            size_t start = ((size_t)block->memory + block->used + align - 1) & ~(align - 1);
+            size_t end = start - (size_t)block->memory + size;
+            if(end <= block->size){
+                arena->used += end - block->used;
+                block->used = end;
+                break;
+            }
+            // The rest of the block is lost until the arena is rewound
+            arena->used += block->size - block->used;
+            block->used = block->size;
+        }
+
+        if(block != NULL && block->next != NULL){
+            block = block->next; // Free block left by a previous release
+            block->used = 0;
+        }
+        else{
+            size_t blockSize = arena->blockSize != 0 ? arena->blockSize : ARENA_BLOCK_SIZE;
+            ArenaBlock *newBlock = createBlock(size + align > blockSize ? size + align : blockSize);
+            arena->reserved += newBlock->size;
+            if(newBlock->kind == PAGES_HUGE){
+                arena->hugeReserved += newBlock->size;
+            }
+            if(block == NULL){
+                newBlock->next = arena->first;
+                arena->first = newBlock;
+            }
+            else{
+                block->next = newBlock;
+            }
+            block = newBlock;
+        }
+        arena->current = block;
+    }
+
+    arena->allocations++;
+    if(arena->used > arena->peak){
+        arena->peak = arena->used;
+    }
+    return (void *)(((size_t)block->memory + block->used - size));
+}
+
+ArenaMark arenaMark(const Arena *arena){
+    ArenaMark mark = {arena->current, arena->current != NULL ? arena->current->used : 0, arena->used};
+    return mark;
+}
+
+// Everything allocated after the mark is given back, the blocks are kept for the next allocations
+void arenaRelease(Arena *arena, ArenaMark mark){
+    arena->current = mark.block;
+    if(mark.block == NULL){
+        arena->current = arena->first;
+        if(arena->current != NULL){
+            arena->current->used = 0;
+        }
+    }
+    else{
+        mark.block->used = mark.blockUsed;
+    }
+    arena->used = mark.used;
+}
+
+void resetArena(Arena *arena){
+    ArenaMark empty = {NULL, 0, 0};
+    arenaRelease(arena, empty);
+}
+
+void freeArena(Arena *arena){
+    ArenaBlock *block = arena->first;
+    while(block != NULL){
+        ArenaBlock *next = block->next;
+        destroyBlock(block);
+        block = next;
+    }
+    initArena(arena, arena->name, arena->blockSize);
+}
+
+void printArenaStats(const Arena *arena){
+    printf("arena %-10s peak %10zu B  reserved %10zu B  (%zu B on huge pages)  %lu allocations\n",
+           arena->name != NULL ? arena->name : "?", arena->peak, arena->reserved, arena->hugeReserved, arena->allocations);
+}
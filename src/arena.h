@@ -0,0 +1,63 @@
+/*
+    Description:
+        Arena allocator owning every buffer of the simulation (grids, per-thread scratch, published frames,
+        screen copies, ...). Memory is handed out by bumping a pointer inside large blocks and is never freed
+        one allocation at a time: an arena is rewound to a mark (arenaRelease()), emptied (resetArena(), e.g.
+        every generation for temporary data) or given back to the system (freeArena()). Blocks of at least
+        HUGE_PAGE_SIZE are mapped on huge pages when possible.
+
+        An arena is not thread-safe: every thread uses its own (see engineScratch()).
+        A zero-initialised Arena is valid and uses ARENA_BLOCK_SIZE blocks.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (1u << 20)
+#define HUGE_PAGE_SIZE (2u << 20) // Blocks of at least one huge page are mapped instead of malloc()-ed
+#define CACHE_LINE 64
+
+typedef enum PageKind{
+    PAGES_HEAP,  // malloc()
+    PAGES_MAPPED, // mmap() with transparent huge pages requested
+    PAGES_HUGE   // mmap() on explicit huge pages
+} PageKind;
+
+typedef struct ArenaBlock{
+    struct ArenaBlock *next;
+    unsigned char *memory;
+    size_t size;
+    size_t used;
+    PageKind kind;
+} ArenaBlock;
+
+typedef struct Arena{
+    const char *name;
+    size_t blockSize;    // Size of a new block, 0 for ARENA_BLOCK_SIZE
+    ArenaBlock *first;
+    ArenaBlock *current; // Blocks after current are free
+    size_t used;         // Bytes handed out, alignment included
+    size_t peak;         // Highest value of used
+    size_t reserved;     // Bytes obtained from the system
+    size_t hugeReserved; // Part of reserved on explicit huge pages
+    unsigned long allocations;
+} Arena;
+
+typedef struct ArenaMark{
+    ArenaBlock *block;
+    size_t blockUsed;
+    size_t used;
+} ArenaMark;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+void initArena(Arena *arena, const char *name, size_t blockSize);
+void *arenaAlloc(Arena *arena, size_t size, size_t align);
+ArenaMark arenaMark(const Arena *arena);
+void arenaRelease(Arena *arena, ArenaMark mark);
+void resetArena(Arena *arena);
+void freeArena(Arena *arena);
+void printArenaStats(const Arena *arena);
+
+#endif
@@ -0,0 +1,177 @@
+/*
+    Description:
+        Batches of small boards stepped together, bit-sliced 64 boards to a word (see batch.h).
+*/
+
+#include <string.h>
+#include "batch.h"
+
+// Every board runs Conway's rule until setBoardRule(), the batch is bounded until its topology is changed
+void createBatch(Batch *batch, int rows, int cols, int boards, Arena *arena){
+    batch->rows = rows;
+    batch->cols = cols;
+    batch->boards = boards < 1 ? 1 : (boards > BATCH_BOARDS ? BATCH_BOARDS : boards);
+    batch->stride = cols + 2;
+    batch->topology = TOPOLOGY_BOUNDED;
+
+    size_t size = (size_t)(rows + 2) * batch->stride * sizeof(unsigned long long);
+    batch->cells = arenaAlloc(arena, size, CACHE_LINE);
+    batch->next = arenaAlloc(arena, size, CACHE_LINE);
+    batch->counts = arenaAlloc(arena, 4 * batch->stride * sizeof(unsigned long long), CACHE_LINE);
+    memset(batch->cells, 0, size);
+    memset(batch->next, 0, size);
+
+    Rule conway;
+    parseRule(CONWAY_RULE, &conway);
+    memset(batch->birth, 0, sizeof(batch->birth));
+    memset(batch->survival, 0, sizeof(batch->survival));
+    for(int board = 0; board < batch->boards; ++board){
+        setBoardRule(batch, board, &conway);
+    }
+}
+
+// Return 1 on success, 0 if the rule isn't a 2-state rule of the square tiling
+int setBoardRule(Batch *batch, int board, const Rule *rule){
+    if(board < 0 || board >= batch->boards || rule->states != 2 || rule->radius > 0 || rule->tiling != TILING_SQUARE){
+        return 0;
+    }
+    unsigned long long bit = 1ull << board;
+    for(int n = 0; n < BATCH_COUNTS; ++n){
+        batch->birth[n] = (batch->birth[n] & ~bit) | ((rule->birth >> n) & 1 ? bit : 0);
+        batch->survival[n] = (batch->survival[n] & ~bit) | ((rule->survival >> n) & 1 ? bit : 0);
+    }
+    return 1;
+}
+
+// The dying cells of a Generations map are read as dead
+void loadBoard(Batch *batch, int board, const Grid *map){
+    for(int i = 0; i < batch->rows; ++i){
+        for(int j = 0; j < batch->cols; ++j){
+            setBoardCell(batch, board, i, j, getCell(map, i, j) == ALIVE);
+        }
+    }
+}
+
+void storeBoard(const Batch *batch, int board, Grid *map){
+    for(int i = 0; i < batch->rows; ++i){
+        for(int j = 0; j < batch->cols; ++j){
+            setCell(map, i, j, getBoardCell(batch, board, i, j));
+        }
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Kernel ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// On a torus the padding repeats the opposite edges, corners included; on a bounded batch it is dead, written
+// at every step since the batch may have been a torus before
+static void padEdges(Batch *batch){
+    int stride = batch->stride;
+    int torus = batch->topology == TOPOLOGY_TORUS;
+    for(int i = 1; i <= batch->rows; ++i){
+        unsigned long long *row = batch->cells + (size_t)i * stride;
+        row[0] = torus ? row[batch->cols] : 0;
+        row[batch->cols + 1] = torus ? row[1] : 0;
+    }
+    unsigned long long *top = batch->cells, *bottom = batch->cells + (size_t)(batch->rows + 1) * stride;
+    if(torus){
+        memcpy(top, batch->cells + (size_t)batch->rows * stride, stride * sizeof(unsigned long long));
+        memcpy(bottom, batch->cells + stride, stride * sizeof(unsigned long long));
+    }
+    else{
+        memset(top, 0, stride * sizeof(unsigned long long));
+        memset(bottom, 0, stride * sizeof(unsigned long long));
+    }
+}
+
+// Bit planes of the neighbour counts of padded row i + 1, from padded rows i to i + 2
+static void countRow(const Batch *batch, int i){
+    const unsigned long long *restrict up = batch->cells + (size_t)i * batch->stride;
+    const unsigned long long *restrict middle = up + batch->stride;
+    const unsigned long long *restrict down = middle + batch->stride;
+    unsigned long long *restrict count0 = batch->counts;
+    unsigned long long *restrict count1 = count0 + batch->stride;
+    unsigned long long *restrict count2 = count1 + batch->stride;
+    unsigned long long *restrict count3 = count2 + batch->stride;
+
+    for(int j = 1; j <= batch->cols; ++j){
+        unsigned long long a = up[j - 1], b = up[j], c = up[j + 1];
+        unsigned long long d = middle[j - 1], e = middle[j + 1];
+        unsigned long long f = down[j - 1], g = down[j], h = down[j + 1];
+
+        // Three full adders and a half adder give 4 bits of weight 1 and 4 bits of weight 2
+        unsigned long long ab = a ^ b, de = d ^ e;
+        unsigned long long ones1 = ab ^ c, twos1 = (a & b) | (c & ab);
+        unsigned long long ones2 = de ^ f, twos2 = (d & e) | (f & de);
+        unsigned long long ones3 = g ^ h, twos3 = g & h;
+
+        // The weight-1 bits are summed into bit 0 and a carry of weight 2
+        unsigned long long ones12 = ones1 ^ ones2;
+        unsigned long long bit0 = ones12 ^ ones3;
+        unsigned long long carry = (ones1 & ones2) | (ones3 & ones12);
+
+        // The 4 weight-2 bits into bits 1 to 3
+        unsigned long long twos12 = twos1 ^ twos2;
+        unsigned long long twos = twos12 ^ twos3, fours = (twos1 & twos2) | (twos3 & twos12);
+        unsigned long long bit1 = twos ^ carry, fours2 = twos & carry;
+        count0[j] = bit0;
+        count1[j] = bit1;
+        count2[j] = fours ^ fours2;
+        count3[j] = fours & fours2;
+    }
+}
+
+// Next state of padded row i + 1: OR over the counts used by a rule of the batch
+static void ruleRow(Batch *batch, int i, const int *used, int usedCount){
+    const unsigned long long *restrict middle = batch->cells + (size_t)(i + 1) * batch->stride;
+    unsigned long long *restrict out = batch->next + (size_t)(i + 1) * batch->stride;
+    const unsigned long long *count0 = batch->counts;
+    const unsigned long long *count1 = count0 + batch->stride;
+    const unsigned long long *count2 = count1 + batch->stride;
+    const unsigned long long *count3 = count2 + batch->stride;
+
+    memset(out + 1, 0, batch->cols * sizeof(unsigned long long));
+    for(int k = 0; k < usedCount; ++k){
+        int n = used[k];
+        unsigned long long birth = batch->birth[n], survival = batch->survival[n];
+        // A bit of the count equals the bit of n when it is XORed with its complement
+        unsigned long long m0 = n & 1 ? 0 : ~0ull, m1 = n & 2 ? 0 : ~0ull;
+        unsigned long long m2 = n & 4 ? 0 : ~0ull, m3 = n & 8 ? 0 : ~0ull;
+        for(int j = 1; j <= batch->cols; ++j){
+            unsigned long long equal = (count0[j] ^ m0) & (count1[j] ^ m1) & (count2[j] ^ m2) & (count3[j] ^ m3);
+            out[j] |= equal & ((middle[j] & survival) | (~middle[j] & birth));
+        }
+    }
+}
+
+// One generation of every board
+void stepBatch(Batch *batch){
+    int used[BATCH_COUNTS], usedCount = 0;
+    for(int n = 0; n < BATCH_COUNTS; ++n){
+        if((batch->birth[n] | batch->survival[n]) != 0){
+            used[usedCount++] = n;
+        }
+    }
+
+    padEdges(batch);
+    for(int i = 0; i < batch->rows; ++i){
+        countRow(batch, i);
+        ruleRow(batch, i, used, usedCount);
+    }
+
+    unsigned long long *swap = batch->cells;
+    batch->cells = batch->next;
+    batch->next = swap;
+}
+
+// Alive cells of every board, populations[b] for board b
+void batchPopulations(const Batch *batch, unsigned long long *populations){
+    memset(populations, 0, batch->boards * sizeof(unsigned long long));
+    for(int i = 0; i < batch->rows; ++i){
+        const unsigned long long *row = batchWord(batch, i, 0);
+        for(int j = 0; j < batch->cols; ++j){
+            for(unsigned long long word = row[j]; word != 0; word &= word - 1){
+                populations[__builtin_ctzll(word)]++;
+            }
+        }
+    }
+}
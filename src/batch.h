@@ -0,0 +1,80 @@
+/*
+    Description:
+        Batches of up to BATCH_BOARDS small boards of the same size stepped together, each with its own
+        life-like rule. The boards are bit-sliced: cell (i, j) of every board is one 64-bit word, bit b for
+        board b, so every operation of the kernel advances the same cell of all the boards at once, and the
+        compiler vectorises the loops over a row to several cells per instruction.
+
+        The kernel counts the 8 neighbours of a word with a tree of full adders into 4 bit planes (counts 0 to 8),
+        then the next state is the OR, over the counts n that some rule of the batch uses, of
+        (count == n) & (alive ? survival[n] : birth[n]), where birth[n] and survival[n] hold bit b when the rule of
+        board b has that count. A board is advanced with the same instructions whatever its rule.
+
+        Only 2-state rules on the square tiling are batched (see setBoardRule()). Every word row is padded with a
+        word on each side and the board with a row above and below, dead on a bounded batch and copies of the
+        opposite edge on a torus, so the kernel reads its neighbours without a test. Batches are independent,
+        programs with many boards step different batches on different threads.
+
+    Sources:
+        https://en.wikipedia.org/wiki/Bit_slicing
+        https://en.wikipedia.org/wiki/Adder_(electronics)#Full_adder
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "engine.h"
+
+#define BATCH_BOARDS 64
+#define BATCH_COUNTS 9 // Neighbour counts 0 to 8
+
+typedef struct Batch{
+    int rows;
+    int cols;
+    int boards;
+    int stride;                              // Words in a padded row, cols + 2
+    Topology topology;
+    unsigned long long birth[BATCH_COUNTS];  // Bit b is set if board b is born with that many neighbours
+    unsigned long long survival[BATCH_COUNTS];
+    unsigned long long *cells;               // (rows + 2) * stride words, the padding included
+    unsigned long long *next;
+    unsigned long long *counts;              // 4 bit planes of a row of neighbour counts
+} Batch;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+void createBatch(Batch *batch, int rows, int cols, int boards, Arena *arena);
+int setBoardRule(Batch *batch, int board, const Rule *rule);
+void loadBoard(Batch *batch, int board, const Grid *map);
+void storeBoard(const Batch *batch, int board, Grid *map);
+void stepBatch(Batch *batch);
+void batchPopulations(const Batch *batch, unsigned long long *populations);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Accessors ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static inline unsigned long long *batchWord(const Batch *batch, int i, int j){
+    return batch->cells + (size_t)(i + 1) * batch->stride + j + 1;
+}
+
+// 1 if board and cell (i, j) are in the batch
+static inline int inBatch(const Batch *batch, int board, int i, int j){
+    return board >= 0 && board < batch->boards && i >= 0 && j >= 0 && i < batch->rows && j < batch->cols;
+}
+
+// Dead outside the batch
+static inline int getBoardCell(const Batch *batch, int board, int i, int j){
+    if(!inBatch(batch, board, i, j)){
+        return 0;
+    }
+    return (int)((*batchWord(batch, i, j) >> board) & 1);
+}
+
+// Ignored outside the batch
+static inline void setBoardCell(Batch *batch, int board, int i, int j, int alive){
+    if(!inBatch(batch, board, i, j)){
+        return;
+    }
+    unsigned long long *word = batchWord(batch, i, j);
+    *word = (*word & ~(1ull << board)) | (unsigned long long)(alive != 0) << board;
+}
+
+#endif
@@ -0,0 +1,197 @@
+/*
+    Description:
+        Benchmark of the simulation kernels. Every kernel steps the same random soup for the same number of
+        generations with every memory layout, and the throughput is reported in cells updated per second.
+        The time to draw the soup itself (see soup.h) is reported first. For a life-like rule, BATCH_BOARDS
+        small boards of BATCH_SIDE cells are then stepped one after the other by the lookup kernel and all at
+        once by the bit-sliced batch kernel (see batch.h).
+
+    Compilation:
+        gcc  bench.c arena.c batch.c engine.c generations.c grid.c larger.c perf.c prof.c soup.c threads.c -o bench -pthread -Wall -Werror -Wextra -pedantic -O3
+
+    Execution:
+        ./bench [-g generations] [-s size] [-j threads] [-r rule] [-P]
+            -r: rule of the soup, B3/S23 by default, a Generations rule like B2/S/C3 runs the bit-plane
+                kernel and a Larger-than-Life rule like R5,C0,M1,S34..58,B34..45,NM the summed-area-table one
+            -P: read the hardware counters of every kernel (see perf.h)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "batch.h"
+#include "engine.h"
+#include "perf.h"
+#include "soup.h"
+#include "threads.h"
+
+#define DEFAULT_GENERATIONS 1000
+#define DEFAULT_SIZE 256
+#define SOUP_SEED 0x9E3779B97F4A7C15ull
+#define BATCH_SIDE 40
+
+static const char *engineNames[] = {"reference", "lookup", "threaded"};
+static const char *layoutNames[] = {"row", "tiled", "morton"};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+double elapsedSeconds(const struct timespec *start);
+void benchBatch(EngineState *engineState, const Rule *rule, long generations, Arena *arena);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Main ~~~~~~~~~~~~~~~~~~~~~~~ //
+int main(int argc, char *argv[]){
+    long generations = DEFAULT_GENERATIONS;
+    int size = DEFAULT_SIZE;
+    int threads = defaultThreadCount();
+    int counters = 0;
+    Rule rule;
+    parseRule(CONWAY_RULE, &rule);
+    int option;
+    while((option = getopt(argc, argv, "g:j:Pr:s:")) != -1){
+        if(option == 'g'){
+            generations = atol(optarg);
+        }
+        else if(option == 's'){
+            size = atoi(optarg);
+        }
+        else if(option == 'j'){
+            threads = atoi(optarg);
+        }
+        else if(option == 'r'){
+            generations = parseRule(optarg, &rule) ? generations : 0;
+        }
+        else if(option == 'P'){
+            counters = 1;
+        }
+        else{
+            generations = 0;
+        }
+    }
+    if(generations <= 0 || size <= 0 || threads <= 0){
+        printf("\nERROR: main() function => usage: %s [-g generations] [-s size] [-j threads] [-r rule] [-P]\n", argv[0]);
+        exit(1);
+    }
+    if(counters && !perfInit()){
+        printf("hardware counters unavailable (%s)\n", perfError());
+    }
+
+    char ruleText[RULE_TEXT_SIZE];
+    formatRule(&rule, ruleText, sizeof(ruleText));
+    printf("%dx%d cells, %ld generations, %d threads, rule %s\n", size, size, generations, threads, ruleText);
+    printf("%-12s %-8s %12s %16s\n", "kernel", "layout", "seconds", "cells/s");
+
+    Arena gridArena;
+    initArena(&gridArena, "grids", 0);
+    static EngineState engineState; // Lookup table and scratch arenas, too large for the stack
+    initEngineState(&engineState, programPool());
+
+    // Always the same soup so the runs can be compared, drawn once and unpacked in every layout
+    Soup soup = {SOUP_SEED, SOUP_DENSITY, SYMMETRY_NONE};
+    BitGrid bits;
+    createBitGrid(&bits, size, size, &gridArena);
+    startWorkers(threads);
+    struct timespec soupStart;
+    clock_gettime(CLOCK_MONOTONIC, &soupStart);
+    fillSoup(&soup, &bits);
+    double soupSeconds = elapsedSeconds(&soupStart);
+    printf("%-12s %-8s %12.3f %16.0f\n", "soup", "packed", soupSeconds, (double)size * size / soupSeconds);
+
+    for(int e = ENGINE_REFERENCE; e <= ENGINE_THREADED; ++e){
+        initEngine(&engineState, e, &rule); // Tables are built outside of the timed section
+        startWorkers(e == ENGINE_THREADED ? threads : 1);
+
+        for(int l = LAYOUT_ROW_MAJOR; l <= LAYOUT_MORTON; ++l){
+            ArenaMark mark = arenaMark(&gridArena);
+            Grid map, newMap;
+            createGrid(&map, size, size, l, &gridArena, programPool());
+            createGrid(&newMap, size, size, l, &gridArena, programPool());
+            unpackGrid(&bits, &map, programPool());
+
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for(long g = 0; g < generations; ++g){
+                stepMap(&engineState, e, &map, &newMap, &rule);
+                swapGrids(&map, &newMap);
+            }
+            double seconds = elapsedSeconds(&start);
+            printf("%-12s %-8s %12.3f %16.0f\n", engineNames[e], layoutNames[l], seconds, (double)size * size * generations / seconds);
+            if(perfEnabled()){
+                perfReport(generations);
+                perfReset();
+            }
+
+            arenaRelease(&gridArena, mark);
+        }
+    }
+
+    if(rule.states == 2 && rule.radius == 0 && rule.tiling == TILING_SQUARE){
+        benchBatch(&engineState, &rule, generations, &gridArena);
+    }
+    stopWorkers();
+
+    printf("\n");
+    printArenaStats(&gridArena);
+    printArenaStats(engineScratch(&engineState, 0));
+    freeEngineState(&engineState);
+    freeArena(&gridArena);
+
+    return 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Definitions ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+double elapsedSeconds(const struct timespec *start){
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// The same BATCH_BOARDS small soups stepped board by board by the lookup kernel, then as one batch
+void benchBatch(EngineState *engineState, const Rule *rule, long generations, Arena *arena){
+    ArenaMark mark = arenaMark(arena);
+    Grid maps[BATCH_BOARDS], newMaps[BATCH_BOARDS];
+    Batch batch;
+    createBatch(&batch, BATCH_SIDE, BATCH_SIDE, BATCH_BOARDS, arena);
+    BitGrid bits;
+    createBitGrid(&bits, BATCH_SIDE, BATCH_SIDE, arena);
+    for(int b = 0; b < BATCH_BOARDS; ++b){
+        Soup soup = {SOUP_SEED + b, SOUP_DENSITY, SYMMETRY_NONE};
+        fillSoup(&soup, &bits);
+        createGrid(&maps[b], BATCH_SIDE, BATCH_SIDE, LAYOUT_ROW_MAJOR, arena, programPool());
+        createGrid(&newMaps[b], BATCH_SIDE, BATCH_SIDE, LAYOUT_ROW_MAJOR, arena, programPool());
+        unpackGrid(&bits, &maps[b], programPool());
+        setBoardRule(&batch, b, rule);
+        loadBoard(&batch, b, &maps[b]);
+    }
+    double cells = (double)BATCH_SIDE * BATCH_SIDE * BATCH_BOARDS * generations;
+
+    initEngine(engineState, ENGINE_LOOKUP, rule);
+    startWorkers(1);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long g = 0; g < generations; ++g){
+        for(int b = 0; b < BATCH_BOARDS; ++b){
+            stepMap(engineState, ENGINE_LOOKUP, &maps[b], &newMaps[b], rule);
+            swapGrids(&maps[b], &newMaps[b]);
+        }
+    }
+    double seconds = elapsedSeconds(&start);
+    printf("%-12s %-8s %12.3f %16.0f\n", "lookup", "boards", seconds, cells / seconds);
+    if(perfEnabled()){
+        perfReport(generations);
+        perfReset();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(long g = 0; g < generations; ++g){
+        stepBatch(&batch);
+    }
+    seconds = elapsedSeconds(&start);
+    printf("%-12s %-8s %12.3f %16.0f\n", "batch", "boards", seconds, cells / seconds);
+    if(perfEnabled()){
+        perfReport(generations);
+        perfReset();
+    }
+
+    arenaRelease(arena, mark);
+}
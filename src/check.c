@@ -0,0 +1,770 @@
+/*
+    Description:
+        Differential test of the simulation kernels. Every case draws a random board (size, density), rule,
+        topology, memory layout and thread count, then steps it with every kernel and with a deliberately simple
+        oracle written independently of engine.c. The first cell where a kernel diverges from the oracle is
+        reported with the seed of the case, so it can be replayed with -s. The statistics of every step
+        (population, births, deaths and, for every other case, the bounding box) are checked the same way.
+        The generations of the reference kernel are also recorded in a history with a budget too small to keep
+        them all, and rewound to random generations that must match the ones computed (see history.h).
+        Every case also draws a soup of its size (see soup.h), which must be the same with one thread and with
+        the case's threads, have its symmetry and density, and survive a round trip through a Grid, and stamps
+        a random pattern in a random orientation and position, compared with the pattern turned cell by cell.
+        Bounded cases run two simulations of the library (see life.h) from two threads at the same time, both
+        compared with the oracle, while a third thread queries the generations of one of them, and rewind the
+        other one to a snapshot; neither may run a task on the workers of the program. Every case finally steps
+        a batch of up to 64 smaller boards with the case's topology (a bounded batch starts as a torus), each
+        with its own random life-like rule (see batch.h), and compares every board with the oracle.
+
+    Compilation:
+        gcc  check.c arena.c batch.c engine.c generations.c grid.c history.c larger.c life.c pattern.c perf.c prof.c publish.c soup.c threads.c -o check -pthread -Wall -Werror -Wextra -pedantic -O2
+
+    Execution:
+        ./check [-n cases] [-g generations] [-s seed]
+        Exit code 0 when every kernel agrees with the oracle, 1 otherwise.
+*/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "batch.h"
+#include "engine.h"
+#include "history.h"
+#include "life.h"
+#include "pattern.h"
+#include "soup.h"
+#include "threads.h"
+
+#define DEFAULT_CASES 200
+#define DEFAULT_GENERATIONS 64
+#define DEFAULT_SEED 1
+#define MAX_SIDE 150
+#define MAX_LARGER_SIDE 40 // The oracle reads whole neighbourhoods, Larger-than-Life boards are kept small
+#define MAX_THREADS 4
+#define MAX_BATCH_SIDE 40 // Every board of a batch is checked against the oracle
+
+static EngineState engineState; // Lookup table, scratch arenas and statistics of the kernels under test
+
+typedef struct Case{
+    unsigned long long seed;
+    int rows;
+    int cols;
+    Rule rule;
+    Topology topology;
+    GridLayout layout;
+    int threads;
+    int density; // Percentage of alive cells
+} Case;
+
+static const char *engineNames[] = {"reference", "lookup", "threaded"};
+static const char *layoutNames[] = {"row", "tiled", "morton"};
+static const char *topologyNames[] = {"bounded", "torus"};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+unsigned long long nextRandom(unsigned long long *state);
+void drawCase(Case *test, unsigned long long seed);
+void oracleStep(const unsigned char *cells, unsigned char *next, const Case *test);
+int runCase(const Case *test, int generations, Arena *arena);
+int checkStats(const Case *test, const unsigned char *cells, const unsigned char *next, const char *engine, int generation);
+int runHistory(const Case *test, int generations, Arena *arena);
+int runSoup(const Case *test, Arena *arena);
+int runPattern(const Case *test, Arena *arena);
+int runLife(const Case *test, int generations, Arena *arena);
+int runBatch(const Case *test, int generations, Arena *arena);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Main ~~~~~~~~~~~~~~~~~~~~~~~ //
+int main(int argc, char *argv[]){
+    long cases = DEFAULT_CASES;
+    int generations = DEFAULT_GENERATIONS;
+    unsigned long long seed = DEFAULT_SEED;
+    int option;
+    while((option = getopt(argc, argv, "g:n:s:")) != -1){
+        if(option == 'n'){
+            cases = atol(optarg);
+        }
+        else if(option == 'g'){
+            generations = atoi(optarg);
+        }
+        else if(option == 's'){
+            seed = strtoull(optarg, NULL, 0);
+        }
+        else{
+            cases = 0;
+        }
+    }
+    if(cases <= 0 || generations <= 0){
+        printf("\nERROR: main() function => usage: %s [-n cases] [-g generations] [-s seed]\n", argv[0]);
+        exit(1);
+    }
+
+    Arena arena;
+    initArena(&arena, "check", 0);
+    initEngineState(&engineState, programPool());
+    int failures = 0;
+    for(long c = 0; c < cases; ++c){
+        Case test;
+        drawCase(&test, seed + c);
+        ArenaMark mark = arenaMark(&arena);
+        failures += !runCase(&test, generations, &arena) || !runHistory(&test, generations, &arena) || !runSoup(&test, &arena) || !runPattern(&test, &arena)
+                    || !runLife(&test, generations, &arena) || !runBatch(&test, generations, &arena);
+        arenaRelease(&arena, mark);
+    }
+    stopWorkers();
+    freeEngineState(&engineState);
+    freeArena(&arena);
+
+    printf("%ld cases, %d generations each: %d failed\n", cases, generations, failures);
+    return failures > 0;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Definitions ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+unsigned long long nextRandom(unsigned long long *state){
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ull); // splitmix64
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void drawCase(Case *test, unsigned long long seed){
+    unsigned long long state = seed;
+    test->seed = seed;
+    // Small boards are drawn more often, they hit every edge case of the kernels
+    test->rows = 1 + (int)(nextRandom(&state) % (nextRandom(&state) % 2 ? 12 : MAX_SIDE));
+    test->cols = 1 + (int)(nextRandom(&state) % (nextRandom(&state) % 2 ? 12 : MAX_SIDE));
+    test->topology = nextRandom(&state) % 2 ? TOPOLOGY_TORUS : TOPOLOGY_BOUNDED;
+    test->layout = (GridLayout)(nextRandom(&state) % 3);
+    test->threads = 1 + (int)(nextRandom(&state) % MAX_THREADS);
+    test->density = (int)(nextRandom(&state) % 101);
+
+    // One case out of four runs Conway's rule, the others any birth / survival counts on any tiling, a third
+    // of them with 3 to MAX_STATES states (Generations rules)
+    if(nextRandom(&state) % 4 == 0){
+        parseRule(CONWAY_RULE, &test->rule);
+    }
+    else{
+        test->rule = (Rule){.states = 2};
+        test->rule.birth = (unsigned short)(nextRandom(&state) & 0x1FF);
+        test->rule.survival = (unsigned short)(nextRandom(&state) & 0x1FF);
+        test->rule.states = nextRandom(&state) % 3 == 0 ? (unsigned char)(3 + nextRandom(&state) % (MAX_STATES - 2)) : 2;
+        test->rule.tiling = (Tiling)(nextRandom(&state) % 3);
+        if(test->rule.tiling == TILING_HEX){
+            test->rule.birth &= 0x7F;
+            test->rule.survival &= 0x7F;
+        }
+        else if(test->rule.tiling == TILING_TRIANGULAR){
+            test->rule.birth = (unsigned short)(nextRandom(&state) & 0x1FFF);
+            test->rule.survival = (unsigned short)(nextRandom(&state) & 0x1FFF);
+        }
+    }
+
+    // One case out of five turns it into a Larger-than-Life rule, whose ranges are drawn around the expected count
+    if(nextRandom(&state) % 5 == 0){
+        Rule *rule = &test->rule;
+        rule->tiling = TILING_SQUARE;
+        rule->radius = (unsigned char)(1 + nextRandom(&state) % MAX_RADIUS);
+        rule->middle = (unsigned char)(nextRandom(&state) % 2);
+        rule->neighbourhood = nextRandom(&state) % 2 ? NEIGHBOURHOOD_VON_NEUMANN : NEIGHBOURHOOD_MOORE;
+        int cells = rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN ? 2 * rule->radius * (rule->radius + 1) + 1
+                                                                      : (2 * rule->radius + 1) * (2 * rule->radius + 1);
+        int expected = cells * test->density / 100;
+        rule->birthMin = (unsigned short)(nextRandom(&state) % (expected + 1));
+        rule->birthMax = (unsigned short)(rule->birthMin + nextRandom(&state) % (cells / 4 + 1));
+        rule->survivalMin = (unsigned short)(nextRandom(&state) % (expected + 1));
+        rule->survivalMax = (unsigned short)(rule->survivalMin + nextRandom(&state) % (cells / 4 + 1));
+        test->rows = 1 + test->rows % MAX_LARGER_SIDE;
+        test->cols = 1 + test->cols % MAX_LARGER_SIDE;
+    }
+}
+
+// Straightforward next generation, every neighbour is found with modular arithmetic
+void oracleStep(const unsigned char *cells, unsigned char *next, const Case *test){
+    const Rule *rule = &test->rule;
+    int radius = rule->radius > 0 ? rule->radius : 1;
+    int width = rule->tiling == TILING_TRIANGULAR ? 2 : radius;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            int count = 0;
+            for(int di = -radius; di <= radius; ++di){
+                for(int dj = -width; dj <= width; ++dj){
+                    int ni = i + di;
+                    int nj = j + dj;
+                    if(di == 0 && dj == 0 && !rule->middle){
+                        continue;
+                    }
+                    if(rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN && abs(di) + abs(dj) > radius){
+                        continue;
+                    }
+                    if(rule->tiling == TILING_HEX && di != 0 && dj == (i % 2 == 0 ? 1 : -1)){
+                        continue; // Odd rows are shifted to the right, they miss the cell on the left above and below
+                    }
+                    int pointingUp = (i + j) % 2 == 0;
+                    if(rule->tiling == TILING_TRIANGULAR && abs(dj) == 2 && di == (pointingUp ? -1 : 1)){
+                        continue; // The row on the side of the tip only shares the 3 cells around it
+                    }
+                    if(test->topology == TOPOLOGY_TORUS){
+                        ni = ((ni % test->rows) + test->rows) % test->rows;
+                        nj = ((nj % test->cols) + test->cols) % test->cols;
+                    }
+                    else if(ni < 0 || nj < 0 || ni >= test->rows || nj >= test->cols){
+                        continue;
+                    }
+                    count += cells[ni * test->cols + nj] == 1;
+                }
+            }
+            int cell = cells[i * test->cols + j];
+            int born = rule->radius > 0 ? count >= rule->birthMin && count <= rule->birthMax : (rule->birth >> count) & 1;
+            int survive = rule->radius > 0 ? count >= rule->survivalMin && count <= rule->survivalMax
+                                           : (rule->survival >> count) & 1;
+            if(cell == 0){
+                next[i * test->cols + j] = (unsigned char)born;
+            }
+            else if(cell == 1 && survive){
+                next[i * test->cols + j] = 1;
+            }
+            else{
+                next[i * test->cols + j] = (cell + 1) % rule->states; // Alive cells that die are dead with 2 states
+            }
+        }
+    }
+}
+
+// Return 1 if every kernel agrees with the oracle on every generation
+int runCase(const Case *test, int generations, Arena *arena){
+    size_t area = (size_t)test->rows * test->cols;
+    unsigned char *expected = arenaAlloc(arena, area, CACHE_LINE);
+    unsigned char *oracleNext = arenaAlloc(arena, area, CACHE_LINE);
+    unsigned char *initial = arenaAlloc(arena, area, CACHE_LINE);
+
+    unsigned long long state = test->seed ^ 0xC0FFEEull;
+    for(size_t k = 0; k < area; ++k){
+        initial[k] = (int)(nextRandom(&state) % 100) < test->density;
+        if(initial[k] && test->rule.states > 2){
+            initial[k] = (unsigned char)(1 + nextRandom(&state) % (test->rule.states - 1)); // Alive or dying
+        }
+    }
+
+    startWorkers(test->threads);
+    trackBounds(&engineState, (int)(test->seed & 1));
+    for(int e = ENGINE_REFERENCE; e <= ENGINE_THREADED; ++e){
+        Grid map, newMap;
+        createGrid(&map, test->rows, test->cols, test->layout, arena, programPool());
+        createGrid(&newMap, test->rows, test->cols, test->layout, arena, programPool());
+        map.topology = newMap.topology = test->topology;
+        for(int i = 0; i < test->rows; ++i){
+            for(int j = 0; j < test->cols; ++j){
+                setCell(&map, i, j, initial[i * test->cols + j]);
+            }
+        }
+        memcpy(expected, initial, area);
+        initEngine(&engineState, e, &test->rule);
+        TileCounts tiles, expectedTiles;
+        createTileCounts(&tiles, test->rows, test->cols, arena);
+        createTileCounts(&expectedTiles, test->rows, test->cols, arena);
+        trackTiles(&engineState, &tiles);
+
+        for(int g = 1; g <= generations; ++g){
+            stepMap(&engineState, e, &map, &newMap, &test->rule);
+            swapGrids(&map, &newMap);
+            oracleStep(expected, oracleNext, test);
+            if(!checkStats(test, expected, oracleNext, engineNames[e], g)){
+                return 0;
+            }
+            memcpy(expected, oracleNext, area);
+
+            for(int i = 0; i < test->rows; ++i){
+                for(int j = 0; j < test->cols; ++j){
+                    if(getCell(&map, i, j) != expected[i * test->cols + j]){
+                        char rule[RULE_TEXT_SIZE];
+                        formatRule(&test->rule, rule, sizeof(rule));
+                        printf("FAIL seed %llu: %s kernel, %dx%d %s %s, %s, %d threads, density %d%%\n",
+                               test->seed, engineNames[e], test->rows, test->cols, topologyNames[test->topology],
+                               layoutNames[test->layout], rule, test->threads, test->density);
+                        printf("     generation %d, first diverging cell (%d, %d): expected %d, got %d\n",
+                               g, i, j, expected[i * test->cols + j], getCell(&map, i, j));
+                        return 0;
+                    }
+                }
+            }
+            countTiles(&map, &expectedTiles);
+            if(memcmp(tiles.counts, expectedTiles.counts, (size_t)tiles.rows * tiles.cols) != 0){
+                printf("FAIL seed %llu: %s kernel, generation %d: tile counts differ from the alive cells of the map\n",
+                       test->seed, engineNames[e], g);
+                return 0;
+            }
+        }
+    }
+    trackTiles(&engineState, NULL);
+    return 1;
+}
+
+// Return 1 if the statistics of the last step are the ones of the oracle's step from cells to next
+int checkStats(const Case *test, const unsigned char *cells, const unsigned char *next, const char *engine, int generation){
+    StepStats expected = {0, 0, 0, test->rows, -1, test->cols, -1}, got;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            int before = cells[i * test->cols + j], after = next[i * test->cols + j];
+            expected.births += before == DEAD && after == ALIVE;
+            expected.deaths += before == ALIVE && after != ALIVE;
+            if(after == ALIVE){
+                expected.population++;
+                if(boundsTracked(&engineState)){
+                    expected.minRow = i < expected.minRow ? i : expected.minRow;
+                    expected.maxRow = i > expected.maxRow ? i : expected.maxRow;
+                    expected.minCol = j < expected.minCol ? j : expected.minCol;
+                    expected.maxCol = j > expected.maxCol ? j : expected.maxCol;
+                }
+            }
+        }
+    }
+    stepStats(&engineState, &got);
+    int empty = expected.minRow > expected.maxRow;
+    int same = got.population == expected.population && got.births == expected.births && got.deaths == expected.deaths;
+    same &= empty ? got.minRow > got.maxRow : got.minRow == expected.minRow && got.maxRow == expected.maxRow &&
+                                             got.minCol == expected.minCol && got.maxCol == expected.maxCol;
+    if(!same){
+        printf("FAIL seed %llu: %s kernel, generation %d statistics: population %llu births %llu deaths %llu box %d..%d x %d..%d,"
+               " expected %llu %llu %llu %d..%d x %d..%d\n", test->seed, engine, generation, got.population, got.births,
+               got.deaths, got.minRow, got.maxRow, got.minCol, got.maxCol, expected.population, expected.births,
+               expected.deaths, expected.minRow, expected.maxRow, expected.minCol, expected.maxCol);
+        return 0;
+    }
+    return 1;
+}
+
+// Return 1 if every generation restored from the history is the one that was recorded
+int runHistory(const Case *test, int generations, Arena *arena){
+    size_t area = (size_t)test->rows * test->cols;
+    unsigned char *recorded = arenaAlloc(arena, (generations + 1) * area, CACHE_LINE);
+    Grid map, newMap;
+    createGrid(&map, test->rows, test->cols, test->layout, arena, programPool());
+    createGrid(&newMap, test->rows, test->cols, test->layout, arena, programPool());
+    map.topology = newMap.topology = test->topology;
+
+    unsigned long long state = test->seed ^ 0xC0FFEEull;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            setCell(&map, i, j, (int)(nextRandom(&state) % 100) < test->density);
+        }
+    }
+
+    // About a third of the generations fit in the budget once the entries are paid for
+    History history;
+    initHistory(&history, test->rows, test->cols, 16 * 40 + 8192 + area * generations / 3, arena);
+    initEngine(&engineState, ENGINE_REFERENCE, &test->rule);
+    for(int g = 0; g <= generations; ++g){
+        if(g > 0){
+            stepMap(&engineState, ENGINE_REFERENCE, &map, &newMap, &test->rule);
+            swapGrids(&map, &newMap);
+        }
+        recordGeneration(&history, &map, g);
+        for(int i = 0; i < test->rows; ++i){
+            for(int j = 0; j < test->cols; ++j){
+                recorded[g * area + (size_t)i * test->cols + j] = getCell(&map, i, j);
+            }
+        }
+    }
+
+    long long current = generations;
+    for(int r = 0; r < 2 * generations; ++r){
+        long long target = (long long)(nextRandom(&state) % (generations + 3)) - 1;
+        int kept = target >= oldestGeneration(&history) && target <= newestGeneration(&history);
+        if(restoreGeneration(&history, &map, current, target) != kept){
+            printf("FAIL seed %llu: history of generations %lld to %lld, restoring %lld %s\n", test->seed,
+                   oldestGeneration(&history), newestGeneration(&history), target, kept ? "failed" : "succeeded");
+            return 0;
+        }
+        if(!kept){
+            continue;
+        }
+        current = target;
+        for(int i = 0; i < test->rows; ++i){
+            for(int j = 0; j < test->cols; ++j){
+                if(getCell(&map, i, j) != recorded[target * area + (size_t)i * test->cols + j]){
+                    printf("FAIL seed %llu: generation %lld restored from the history differs at (%d, %d)\n",
+                           test->seed, target, i, j);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Return 1 if the soup of the case doesn't depend on the threads and has its symmetry and density
+int runSoup(const Case *test, Arena *arena){
+    Soup soup = {test->seed, test->density / 100.0, (Symmetry)(test->seed % (SYMMETRY_D4 + 1))};
+    if(soup.symmetry == SYMMETRY_C4 && test->rows != test->cols){
+        soup.symmetry = SYMMETRY_D4;
+    }
+    BitGrid single, parallel;
+    createBitGrid(&single, test->rows, test->cols, arena);
+    createBitGrid(&parallel, test->rows, test->cols, arena);
+    startWorkers(1);
+    fillSoup(&soup, &single);
+    startWorkers(test->threads);
+    fillSoup(&soup, &parallel);
+
+    long alive = 0;
+    for(int i = 0; i < test->rows; ++i){
+        if(memcmp(bitRow(&single, i), bitRow(&parallel, i), single.words * sizeof(unsigned long long)) != 0){
+            printf("FAIL seed %llu: soup row %d differs with %d threads\n", test->seed, i, test->threads);
+            return 0;
+        }
+        if(test->cols & 63 && bitRow(&single, i)[single.words - 1] >> (test->cols & 63)){
+            printf("FAIL seed %llu: soup row %d has cells after column %d\n", test->seed, i, test->cols - 1);
+            return 0;
+        }
+        for(int j = 0; j < test->cols; ++j){
+            int cell = getBit(&single, i, j);
+            int mirrorI = test->rows - 1 - i, mirrorJ = test->cols - 1 - j;
+            int symmetric = 1;
+            if(soup.symmetry == SYMMETRY_C2){
+                symmetric = cell == getBit(&single, mirrorI, mirrorJ);
+            }
+            else if(soup.symmetry == SYMMETRY_C4){
+                symmetric = cell == getBit(&single, j, mirrorI);
+            }
+            else if(soup.symmetry == SYMMETRY_D2 || soup.symmetry == SYMMETRY_D4){
+                symmetric = cell == getBit(&single, i, mirrorJ);
+                symmetric &= soup.symmetry == SYMMETRY_D2 || cell == getBit(&single, mirrorI, j);
+            }
+            if(!symmetric){
+                printf("FAIL seed %llu: soup of symmetry %d, cell (%d, %d) breaks it\n", test->seed, soup.symmetry, i, j);
+                return 0;
+            }
+            alive += cell;
+        }
+    }
+
+    // Only the symmetry-free soups are made of independent cells, 5 standard deviations at most
+    double area = (double)test->rows * test->cols;
+    double expected = (int)(soup.density * 256 + 0.5) / 256.0;
+    double deviation = area * expected * (1 - expected);
+    double error = alive - area * expected;
+    if(soup.symmetry == SYMMETRY_NONE && error * error > 25 * deviation + 1){
+        printf("FAIL seed %llu: soup of density %.3f has %ld alive cells out of %.0f\n", test->seed, expected, alive, area);
+        return 0;
+    }
+
+    Grid map;
+    createGrid(&map, test->rows, test->cols, test->layout, arena, programPool());
+    unpackGrid(&single, &map, programPool());
+    packGrid(&map, &parallel, programPool());
+    if(memcmp(single.bits, parallel.bits, (size_t)single.rows * single.words * sizeof(unsigned long long)) != 0){
+        printf("FAIL seed %llu: soup packed again after unpackGrid() differs\n", test->seed);
+        return 0;
+    }
+    return 1;
+}
+
+// Return 1 if a random pattern is stamped where its turned and clipped cells are expected
+int runPattern(const Case *test, Arena *arena){
+    unsigned long long state = test->seed ^ 0x5EEDull;
+    PatternLibrary library;
+    initPatternLibrary(&library, ".", arena);
+    Pattern pattern;
+    memset(&pattern, 0, sizeof(pattern));
+    pattern.rows = 1 + (int)(nextRandom(&state) % 20);
+    pattern.cols = 1 + (int)(nextRandom(&state) % 140);
+    pattern.cells = arenaAlloc(arena, (size_t)pattern.rows * pattern.cols, 1);
+    for(int k = 0; k < pattern.rows * pattern.cols; ++k){
+        pattern.cells[k] = nextRandom(&state) % 2;
+    }
+    int orientation = (int)(nextRandom(&state) % ORIENTATIONS);
+    int row = (int)(nextRandom(&state) % (test->rows + 2 * pattern.cols)) - pattern.cols;
+    int col = (int)(nextRandom(&state) % (test->cols + 2 * pattern.cols)) - pattern.cols;
+
+    // Mirror, then turn a quarter clockwise at a time: turned[r][c] = cells[h - 1 - c][r]
+    int height = pattern.rows, width = pattern.cols;
+    unsigned char *oriented = arenaAlloc(arena, (size_t)height * width, 1);
+    unsigned char *turned = arenaAlloc(arena, (size_t)height * width, 1);
+    for(int i = 0; i < height; ++i){
+        for(int j = 0; j < width; ++j){
+            int source = orientation & ORIENTATION_MIRROR ? width - 1 - j : j;
+            oriented[i * width + j] = pattern.cells[i * width + source];
+        }
+    }
+    for(int t = 0; t < (orientation & 3); ++t){
+        for(int r = 0; r < width; ++r){
+            for(int c = 0; c < height; ++c){
+                turned[r * height + c] = oriented[(height - 1 - c) * width + r];
+            }
+        }
+        memcpy(oriented, turned, (size_t)height * width);
+        int swap = height;
+        height = width;
+        width = swap;
+    }
+
+    // Stamped twice: ORing the same cells again changes nothing
+    BitGrid grid;
+    createBitGrid(&grid, test->rows, test->cols, arena);
+    stampPattern(&library, &pattern, orientation, &grid, row, col);
+    stampPattern(&library, &pattern, orientation, &grid, row, col);
+    for(int i = 0; i < test->rows; ++i){
+        if(test->cols & 63 && bitRow(&grid, i)[grid.words - 1] >> (test->cols & 63)){
+            printf("FAIL seed %llu: pattern stamped after column %d\n", test->seed, test->cols - 1);
+            return 0;
+        }
+        for(int j = 0; j < test->cols; ++j){
+            int r = i - row, c = j - col;
+            int expected = r >= 0 && r < height && c >= 0 && c < width && oriented[r * width + c];
+            if(getBit(&grid, i, j) != expected){
+                printf("FAIL seed %llu: %dx%d pattern in orientation %d at (%d, %d) on %dx%d, cell (%d, %d): expected %d\n",
+                       test->seed, pattern.rows, pattern.cols, orientation, row, col, test->rows, test->cols, i, j, expected);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+typedef struct LifeRun{
+    Life *life;
+    long long generations;
+    int consistent; // Set by readLife()
+} LifeRun;
+
+static void *stepLife(void *arg){
+    LifeRun *run = arg;
+    lifeStep(run->life, run->generations);
+    return NULL;
+}
+
+// Query the latest generation of a simulation while it steps, until the last one: the generations never go back,
+// the population of a rectangle, read from the tile counts, is the one of its cells, and the previous snapshot,
+// held meanwhile, still has the population it had when it was taken
+static void *readLife(void *arg){
+    LifeRun *run = arg;
+    int rows = lifeRows(run->life), cols = lifeCols(run->life);
+    long long generation = -1;
+    LifeSnapshot *previous = NULL;
+    unsigned long long previousPopulation = 0;
+    run->consistent = 1;
+    while(generation < run->generations && run->consistent){
+        LifeSnapshot *snapshot = lifeLatest(run->life);
+        if(snapshot == NULL){
+            run->consistent = 0;
+            break;
+        }
+        run->consistent &= lifeSnapshotGeneration(snapshot) >= generation;
+        generation = lifeSnapshotGeneration(snapshot);
+        int row = (int)(generation % rows) - 1, col = (int)(generation % cols) - 1;
+        int height = 1 + (int)(generation % 17), width = cols - col;
+        unsigned long long population = 0;
+        for(int i = row; i < row + height; ++i){
+            for(int j = col; j < col + width; ++j){
+                population += lifeSnapshotCell(snapshot, i, j) == ALIVE;
+            }
+        }
+        run->consistent &= lifeSnapshotPopulation(snapshot, row, col, height, width) == population;
+
+        if(previous != NULL){
+            run->consistent &= lifeSnapshotPopulation(previous, 0, 0, rows, cols) == previousPopulation;
+            lifeFreeSnapshot(previous);
+        }
+        previous = snapshot;
+        previousPopulation = 0;
+        for(int i = 0; i < rows; ++i){
+            for(int j = 0; j < cols; ++j){
+                previousPopulation += lifeSnapshotCell(snapshot, i, j) == ALIVE;
+            }
+        }
+    }
+    lifeFreeSnapshot(previous);
+    return NULL;
+}
+
+// Return 1 if two simulations of the library, stepped at the same time by two threads, both reach the oracle's
+// generation, count the alive cells of a rectangle right and replay the same generations from a snapshot that
+// didn't change meanwhile, and if a third thread reads consistent generations of the first one while it steps
+int runLife(const Case *test, int generations, Arena *arena){
+    if(test->topology != TOPOLOGY_BOUNDED){
+        return 1; // The boards of the library are bounded
+    }
+    char rule[RULE_TEXT_SIZE];
+    formatRule(&test->rule, rule, sizeof(rule));
+    unsigned long programTasks = programPool()->taskNumber; // The handles only run on their own pools
+    Life *lives[2] = {lifeCreate(test->rows, test->cols, rule, test->threads),
+                      lifeCreate(test->rows, test->cols, rule, 1)};
+    if(lives[0] == NULL || lives[1] == NULL){
+        printf("FAIL seed %llu: lifeCreate() refused rule %s\n", test->seed, rule);
+        lifeDestroy(lives[0]); // Either may have been created, lifeDestroy() ignores NULL
+        lifeDestroy(lives[1]);
+        return 0;
+    }
+
+    size_t area = (size_t)test->rows * test->cols;
+    unsigned char *expected = arenaAlloc(arena, area, CACHE_LINE);
+    unsigned char *oracleNext = arenaAlloc(arena, area, CACHE_LINE);
+    unsigned char *initial = arenaAlloc(arena, area, CACHE_LINE);
+    unsigned long long state = test->seed ^ 0x11FEull;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            int cell = (int)(nextRandom(&state) % 100) < test->density;
+            if(cell && test->rule.states > 2){
+                cell = (int)(1 + nextRandom(&state) % (test->rule.states - 1));
+            }
+            expected[i * test->cols + j] = (unsigned char)cell;
+            lifeSetCell(lives[0], i, j, cell);
+            lifeSetCell(lives[1], i, j, cell);
+        }
+    }
+    memcpy(initial, expected, area);
+    LifeSnapshot *start = lifeSnapshot(lives[1]);
+
+    pthread_t stepper, reader;
+    LifeRun run = {lives[0], generations, 0};
+    pthread_create(&stepper, NULL, stepLife, &run);
+    pthread_create(&reader, NULL, readLife, &run);
+    lifeStep(lives[1], generations);
+    pthread_join(stepper, NULL);
+    pthread_join(reader, NULL);
+    for(int g = 0; g < generations; ++g){
+        oracleStep(expected, oracleNext, test);
+        memcpy(expected, oracleNext, area);
+    }
+
+    int valid = run.consistent && lifeGeneration(lives[0]) == generations;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            valid &= lifeCell(lives[0], i, j) == expected[i * test->cols + j];
+            valid &= lifeCell(lives[1], i, j) == expected[i * test->cols + j];
+        }
+    }
+    int row = (int)(nextRandom(&state) % test->rows) - 2, col = (int)(nextRandom(&state) % test->cols) - 2;
+    int rows = 1 + (int)(nextRandom(&state) % test->rows), cols = 1 + (int)(nextRandom(&state) % test->cols);
+    unsigned long long population = 0;
+    for(int i = row; i < row + rows; ++i){
+        for(int j = col; j < col + cols; ++j){
+            int on = i >= 0 && j >= 0 && i < test->rows && j < test->cols;
+            population += on && expected[i * test->cols + j] == ALIVE;
+        }
+    }
+    valid &= lifePopulation(lives[0], row, col, rows, cols) == population;
+
+    population = 0;
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            valid &= lifeSnapshotCell(start, i, j) == initial[i * test->cols + j];
+            population += initial[i * test->cols + j] == ALIVE;
+        }
+    }
+    valid &= lifeSnapshotPopulation(start, 0, 0, test->rows, test->cols) == population;
+    valid &= lifeRestore(lives[1], start) && lifeGeneration(lives[1]) == 0;
+    lifeStep(lives[1], generations);
+    for(int i = 0; i < test->rows; ++i){
+        for(int j = 0; j < test->cols; ++j){
+            valid &= lifeCell(lives[1], i, j) == expected[i * test->cols + j];
+        }
+    }
+    if(!valid){
+        printf("FAIL seed %llu: library simulations of %dx%d %s, %d threads, differ from the oracle\n", test->seed,
+               test->rows, test->cols, rule, test->threads);
+    }
+    if(programPool()->taskNumber != programTasks){
+        printf("FAIL seed %llu: library simulations ran tasks on the workers of the program\n", test->seed);
+        valid = 0;
+    }
+    lifeFreeSnapshot(start);
+    lifeDestroy(lives[0]);
+    lifeDestroy(lives[1]);
+    return valid;
+}
+
+// Return 1 if every board of a batch, each with its own random life-like rule, matches the oracle and its
+// population; board 0 goes through a Grid with loadBoard() and storeBoard(), the others cell by cell. A bounded
+// batch is a torus for the first half of the generations, so the padding left by the torus must be cleared.
+// Boards outside the batch are never written.
+int runBatch(const Case *test, int generations, Arena *arena){
+    unsigned long long state = test->seed ^ 0xBA7Cull;
+    int boards = 1 + (int)(test->seed % BATCH_BOARDS);
+    Case board = *test;
+    board.rows = 1 + test->rows % MAX_BATCH_SIDE;
+    board.cols = 1 + test->cols % MAX_BATCH_SIDE;
+    Batch batch;
+    createBatch(&batch, board.rows, board.cols, boards, arena);
+    batch.topology = test->topology;
+
+    size_t area = (size_t)board.rows * board.cols;
+    Case *cases = arenaAlloc(arena, boards * sizeof(Case), CACHE_LINE);
+    unsigned char *expected = arenaAlloc(arena, boards * area, CACHE_LINE);
+    unsigned char *oracleNext = arenaAlloc(arena, area, CACHE_LINE);
+    Grid map;
+    createGrid(&map, board.rows, board.cols, test->layout, arena, programPool());
+    int valid = 1;
+    for(int b = 0; b < boards; ++b){
+        cases[b] = board;
+        Rule *rule = &cases[b].rule;
+        memset(rule, 0, sizeof(*rule));
+        rule->birth = (unsigned short)(nextRandom(&state) & 0x1FF);
+        rule->survival = (unsigned short)(nextRandom(&state) & 0x1FF);
+        rule->states = 2;
+        rule->tiling = TILING_SQUARE;
+        valid &= setBoardRule(&batch, b, rule);
+
+        unsigned char *cells = expected + b * area;
+        for(size_t k = 0; k < area; ++k){
+            cells[k] = (unsigned char)((int)(nextRandom(&state) % 100) < test->density);
+        }
+        for(int i = 0; i < board.rows; ++i){
+            for(int j = 0; j < board.cols; ++j){
+                if(b == 0){
+                    setCell(&map, i, j, cells[i * board.cols + j]);
+                }
+                else{
+                    setBoardCell(&batch, b, i, j, cells[i * board.cols + j]);
+                }
+            }
+        }
+    }
+    loadBoard(&batch, 0, &map);
+    setBoardCell(&batch, BATCH_BOARDS, 0, 0, 1);
+    setBoardCell(&batch, -1, 0, 0, 1);
+    valid &= getBoardCell(&batch, BATCH_BOARDS, 0, 0) == 0 && getBoardCell(&batch, boards, 0, 0) == 0;
+
+    int wrapped = test->topology == TOPOLOGY_BOUNDED ? generations / 2 : 0; // Generations stepped as a torus
+    for(int g = 0; g < generations; ++g){
+        batch.topology = g < wrapped ? TOPOLOGY_TORUS : test->topology;
+        stepBatch(&batch);
+    }
+    unsigned long long populations[BATCH_BOARDS];
+    batchPopulations(&batch, populations);
+    storeBoard(&batch, 0, &map);
+    for(int b = 0; b < boards && valid; ++b){
+        unsigned char *cells = expected + b * area;
+        for(int g = 0; g < generations; ++g){
+            cases[b].topology = g < wrapped ? TOPOLOGY_TORUS : test->topology;
+            oracleStep(cells, oracleNext, &cases[b]);
+            memcpy(cells, oracleNext, area);
+        }
+        unsigned long long population = 0;
+        for(int i = 0; i < board.rows; ++i){
+            for(int j = 0; j < board.cols; ++j){
+                int cell = b == 0 ? getCell(&map, i, j) : getBoardCell(&batch, b, i, j);
+                if(cell != cells[i * board.cols + j]){
+                    char rule[RULE_TEXT_SIZE];
+                    formatRule(&cases[b].rule, rule, sizeof(rule));
+                    printf("FAIL seed %llu: board %d/%d of a %dx%d %s batch, %s, differs from the oracle at (%d, %d): %d instead of %d\n",
+                           test->seed, b, boards, board.rows, board.cols, topologyNames[test->topology], rule, i, j, cell,
+                           cells[i * board.cols + j]);
+                    return 0;
+                }
+                population += cell;
+            }
+        }
+        if(populations[b] != population){
+            printf("FAIL seed %llu: board %d/%d of a batch counts %llu alive cells instead of %llu\n", test->seed, b, boards,
+                   populations[b], population);
+            return 0;
+        }
+    }
+    if(!valid){
+        printf("FAIL seed %llu: setBoardRule() refused a life-like rule or a board outside the batch was read\n",
+               test->seed);
+    }
+    return valid;
+}
@@ -0,0 +1,638 @@
+/*
+    Description:
+        Simulation engine of the game of life (see engine.h).
+
+    Sources:
+        https://conwaylife.com/wiki/Rulestring
+        https://conwaylife.com/wiki/Larger_than_Life
+        http://www.ibiblio.org/e-notes/Life/Quadratic.htm (table-driven 2x2 block update)
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "engine.h"
+#include "perf.h"
+#include "prof.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Rule ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Read a number of at most max, return the character after it or NULL
+static const char *parseNumber(const char *text, int max, int *number){
+    if(!isdigit((unsigned char)*text)){
+        return NULL;
+    }
+    *number = 0;
+    while(isdigit((unsigned char)*text)){
+        *number = *number * 10 + (*text++ - '0');
+        if(*number > max){
+            return NULL;
+        }
+    }
+    return text;
+}
+
+// Read a Larger-than-Life rule written as "R5,C0,M1,S34..58,B34..45,NM" (radius, states, middle cell counted,
+// survival range, birth range, Moore or von Neumann neighbourhood). Return 1 on success, 0 otherwise.
+static int parseLarger(const char *text, Rule *rule){
+    Rule parsed = {.states = 2, .radius = 1};
+    int value, low, high;
+
+    for(const char *c = text; *c != '\0';){
+        char field = (char)toupper((unsigned char)*c++);
+        if(field == 'N'){
+            char shape = (char)toupper((unsigned char)*c++);
+            if(shape != 'M' && shape != 'N'){
+                return 0;
+            }
+            parsed.neighbourhood = shape == 'N' ? NEIGHBOURHOOD_VON_NEUMANN : NEIGHBOURHOOD_MOORE;
+        }
+        else if(field == 'R' && (c = parseNumber(c, MAX_RADIUS, &value)) != NULL && value > 0){
+            parsed.radius = (unsigned char)value;
+        }
+        else if(field == 'C' && (c = parseNumber(c, MAX_STATES, &value)) != NULL){
+            parsed.states = (unsigned char)(value > 2 ? value : 2); // C0 and C2 both mean 2 states
+        }
+        else if(field == 'M' && (c = parseNumber(c, 1, &value)) != NULL){
+            parsed.middle = (unsigned char)value;
+        }
+        else if((field == 'S' || field == 'B') && (c = parseNumber(c, 0xFFFF, &low)) != NULL){
+            high = low;
+            if(c[0] == '.' && c[1] == '.' && (c = parseNumber(c + 2, 0xFFFF, &high)) == NULL){
+                return 0;
+            }
+            *(field == 'S' ? &parsed.survivalMin : &parsed.birthMin) = (unsigned short)low;
+            *(field == 'S' ? &parsed.survivalMax : &parsed.birthMax) = (unsigned short)high;
+        }
+        else{
+            return 0;
+        }
+
+        if(c == NULL || (*c != ',' && *c != '\0')){
+            return 0;
+        }
+        c += *c == ',';
+    }
+
+    *rule = parsed;
+    return 1;
+}
+
+// Greatest neighbour count of a tiling
+static int tilingNeighbours(Tiling tiling){
+    return tiling == TILING_HEX ? 6 : tiling == TILING_TRIANGULAR ? 12 : 8;
+}
+
+// Read a rule written as "B3/S23" (birth / survival neighbour counts), followed by "/C3" for a Generations rule
+// with 3 states and by "H" or "L" for the hexagonal or triangular tiling, or a Larger-than-Life rule starting
+// with "R". Return 1 on success, 0 otherwise.
+int parseRule(const char *text, Rule *rule){
+    unsigned short *counts = NULL;
+    int readStates = 0;
+    Rule parsed = {.states = 2};
+
+    if(toupper((unsigned char)text[0]) == 'R'){
+        return parseLarger(text, rule);
+    }
+
+    for(const char *c = text; *c != '\0'; ++c){
+        if(toupper((unsigned char)*c) == 'B'){
+            counts = &parsed.birth;
+        }
+        else if(toupper((unsigned char)*c) == 'S'){
+            counts = &parsed.survival;
+        }
+        else if(toupper((unsigned char)*c) == 'C'){
+            counts = NULL;
+            readStates = 1;
+            parsed.states = 0;
+        }
+        else if(isdigit((unsigned char)*c) && readStates){
+            parsed.states = (unsigned char)(parsed.states * 10 + (*c - '0'));
+            if(parsed.states > MAX_STATES){
+                return 0;
+            }
+        }
+        else if(isdigit((unsigned char)*c) && counts != NULL){
+            *counts |= 1u << (*c - '0');
+        }
+        else if(toupper((unsigned char)*c) >= 'X' && toupper((unsigned char)*c) <= 'Z' && counts != NULL){
+            *counts |= 1u << (toupper((unsigned char)*c) - 'X' + 10);
+        }
+        else if((toupper((unsigned char)*c) == 'H' || toupper((unsigned char)*c) == 'L') && c[1] == '\0'){
+            parsed.tiling = toupper((unsigned char)*c) == 'H' ? TILING_HEX : TILING_TRIANGULAR;
+        }
+        else if(*c != '/'){
+            return 0;
+        }
+    }
+
+    if(parsed.states < 2 || ((parsed.birth | parsed.survival) >> (tilingNeighbours(parsed.tiling) + 1)) != 0){
+        return 0; // More neighbours than the tiling has
+    }
+    *rule = parsed;
+    return 1;
+}
+
+// Write the rule as "B3/S23", "B2/S/C3" for a Generations rule, "B2/S34H" for a hexagonal one or
+// "R5,C0,M1,S34..58,B34..45,NM" for a Larger-than-Life rule
+void formatRule(const Rule *rule, char *text, int size){
+    static const char suffixes[] = {'\0', 'H', 'L'};
+    char counts[2][14];
+
+    if(rule->radius > 0){
+        snprintf(text, size, "R%d,C%d,M%d,S%d..%d,B%d..%d,N%c", rule->radius, rule->states > 2 ? rule->states : 0,
+                 rule->middle, rule->survivalMin, rule->survivalMax, rule->birthMin, rule->birthMax,
+                 rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN ? 'N' : 'M');
+        return;
+    }
+    for(int k = 0; k < 2; ++k){
+        int length = 0;
+        for(int n = 0; n <= tilingNeighbours(rule->tiling); ++n){
+            if((((k == 0 ? rule->birth : rule->survival) >> n) & 1)){
+                counts[k][length++] = (char)(n < 10 ? '0' + n : 'X' + n - 10);
+            }
+        }
+        counts[k][length] = '\0';
+    }
+
+    if(rule->states > 2){
+        snprintf(text, size, "B%s/S%s/C%d%.1s", counts[0], counts[1], rule->states, &suffixes[rule->tiling]);
+    }
+    else{
+        snprintf(text, size, "B%s/S%s%.1s", counts[0], counts[1], &suffixes[rule->tiling]);
+    }
+}
+
+// countNeighbour includes the cell itself for a Larger-than-Life rule with the middle cell
+int nextState(const Rule *rule, int state, int countNeighbour){
+    int survive, born;
+    if(rule->radius > 0){
+        survive = countNeighbour >= rule->survivalMin && countNeighbour <= rule->survivalMax;
+        born = countNeighbour >= rule->birthMin && countNeighbour <= rule->birthMax;
+    }
+    else{
+        survive = (rule->survival >> countNeighbour) & 1;
+        born = (rule->birth >> countNeighbour) & 1;
+    }
+
+    if(state == ALIVE){
+        if(survive){
+            return ALIVE; // Survive
+        }
+        return rule->states > 2 ? 2 : DEAD; // Die because of under/overpopulation, slowly with a Generations rule
+    }
+    if(state == DEAD){
+        return born ? ALIVE : DEAD; // Become alive because of reproduction, or stay dead
+    }
+    return state + 1 < rule->states ? state + 1 : DEAD; // Dying cells ignore their neighbours
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Engine selection ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Read an engine name ("reference", "lookup" or "threaded"). Return 1 on success, 0 otherwise.
+int parseEngine(const char *text, Engine *engine){
+    if(strcmp(text, "reference") == 0){
+        *engine = ENGINE_REFERENCE;
+    }
+    else if(strcmp(text, "lookup") == 0){
+        *engine = ENGINE_LOOKUP;
+    }
+    else if(strcmp(text, "threaded") == 0){
+        *engine = ENGINE_THREADED;
+    }
+    else{
+        return 0;
+    }
+    return 1;
+}
+
+// An engine state without a rule, whose threaded kernels run on pool
+void initEngineState(EngineState *state, WorkerPool *pool){
+    memset(state, 0, sizeof(*state));
+    for(int band = 0; band < MAX_WORKERS; ++band){
+        state->scratch[band].name = "scratch"; // Zero-initialised arenas are valid, only the name is missing
+    }
+    state->pool = pool;
+}
+
+void freeEngineState(EngineState *state){
+    for(int band = 0; band < MAX_WORKERS; ++band){
+        freeArena(&state->scratch[band]);
+    }
+}
+
+// Build what the engine needs for the rule, must be called again when the rule changes
+void initEngine(EngineState *state, Engine engine, const Rule *rule){
+    if((engine == ENGINE_LOOKUP || engine == ENGINE_THREADED) && rule->states == 2 && rule->radius == 0
+       && rule->tiling == TILING_SQUARE){
+        initLookupTable(state, rule);
+    }
+}
+
+void stepMap(EngineState *state, Engine engine, const Grid *map, Grid *newMap, const Rule *rule){
+    int bands = state->pool->count;
+    for(int band = 0; band < bands; ++band){
+        emptyStats(&state->bands[band], map); // Bands without rows don't run
+    }
+
+    if(engine != ENGINE_REFERENCE && rule->radius > 0){
+        updateMapLarger(state, map, newMap, rule, engine == ENGINE_THREADED);
+    }
+    else if(engine != ENGINE_REFERENCE && (rule->states > 2 || rule->tiling != TILING_SQUARE)){
+        updateMapGenerations(state, map, newMap, rule, engine == ENGINE_THREADED);
+    }
+    else if(engine == ENGINE_LOOKUP){
+        updateMapLookup(state, map, newMap);
+    }
+    else if(engine == ENGINE_THREADED){
+        updateMapThreaded(state, map, newMap);
+    }
+    else{
+        updateMap(state, map, newMap, rule);
+    }
+
+    StepStats *last = &state->last;
+    emptyStats(last, map);
+    for(int band = 0; band < bands; ++band){
+        const StepStats *counted = &state->bands[band];
+        last->population += counted->population;
+        last->births += counted->births;
+        last->deaths += counted->deaths;
+        addBounds(last, counted->minRow, counted->maxRow, counted->minCol, counted->maxCol);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Statistics ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// The bounding box costs a comparison per alive word or cell, it is only computed on demand
+void trackBounds(EngineState *state, int enabled){
+    state->trackingBounds = enabled;
+}
+
+int boundsTracked(const EngineState *state){
+    return state->trackingBounds;
+}
+
+// The next stepMap() counts the alive cells of every tile of newMap in tiles (same dimensions), NULL to stop.
+// Every band empties and counts the tiles of its rows, which start on a tile boundary.
+void trackTiles(EngineState *state, TileCounts *tiles){
+    state->tiles = tiles;
+}
+
+// Statistics of the generation computed by the last stepMap()
+void stepStats(const EngineState *state, StepStats *stats){
+    *stats = state->last;
+}
+
+// Population and bounding box of a map that wasn't computed by a kernel (a level, a restored generation)
+void countStats(const Grid *map, StepStats *stats){
+    emptyStats(stats, map);
+    for(int i = 0; i < map->rows; ++i){
+        for(int j = 0; j < map->cols; ++j){
+            if(getCell(map, i, j) == ALIVE){
+                stats->population++;
+                addBounds(stats, i, i, j, j);
+            }
+        }
+    }
+}
+
+// Written once by the kernel of the band, at its end
+StepStats *bandStats(EngineState *state, int band){
+    return &state->bands[band];
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Reference kernel ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+int countNeighbours(const Grid *map, int i, int j){
+    int rows = map->rows;
+    int cols = map->cols;
+    int countNeighbour = 0;
+
+    if(map->topology == TOPOLOGY_TORUS){
+        // The edges wrap around, the neighbours of the first row are in the last one
+        int up = i > 0 ? i - 1 : rows - 1;
+        int down = i < rows - 1 ? i + 1 : 0;
+        int left = j > 0 ? j - 1 : cols - 1;
+        int right = j < cols - 1 ? j + 1 : 0;
+        countNeighbour = (getCell(map, up, left) == ALIVE) + (getCell(map, up, j) == ALIVE) + (getCell(map, up, right) == ALIVE)
+                       + (getCell(map, i, left) == ALIVE) + (getCell(map, i, right) == ALIVE)
+                       + (getCell(map, down, left) == ALIVE) + (getCell(map, down, j) == ALIVE) + (getCell(map, down, right) == ALIVE);
+        return countNeighbour;
+    }
+
+    if((i > 0) && (getCell(map, i - 1, j) == ALIVE)){ // Left cell
+        countNeighbour++;
+    }
+    if((i > 0) && (j > 0) && (getCell(map, i - 1, j - 1) == ALIVE)){ // Top Left cell
+        countNeighbour++;
+    }
+    if((j > 0) && (getCell(map, i, j - 1) == ALIVE)){ // Top cell
+        countNeighbour++;
+    }
+    if((j > 0) && (i < rows - 1) && (getCell(map, i + 1, j - 1) == ALIVE)){ // Top Right cell
+        countNeighbour++;
+    }
+
+    if((i < (rows - 1)) && (getCell(map, i + 1, j) == ALIVE)){ // Right cell
+        countNeighbour++;
+    }
+    if((i < (rows - 1)) && (j < (cols - 1)) && (getCell(map, i + 1, j + 1) == ALIVE)){ // Bottom Right cell
+        countNeighbour++;
+    }
+    if((j < (cols - 1)) && (getCell(map, i, j + 1) == ALIVE)){ // Bottom cell
+        countNeighbour++;
+    }
+    if((i > 0) && (j < (cols - 1)) && (getCell(map, i - 1, j + 1) == ALIVE)){ // Bottom Left cell
+        countNeighbour++;
+    }
+    return countNeighbour;
+}
+
+// Neighbours of a hexagonal or triangular cell, as offsets from the cell
+int countTiling(const Grid *map, Tiling tiling, int i, int j){
+    static const int hexEven[6][2] = {{-1, -1}, {-1, 0}, {0, -1}, {0, 1}, {1, -1}, {1, 0}};
+    static const int hexOdd[6][2] = {{-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, 0}, {1, 1}};
+    static const int triangleUp[12][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -2}, {0, -1}, {0, 1}, {0, 2},
+                                          {1, -2}, {1, -1}, {1, 0}, {1, 1}, {1, 2}};
+    static const int triangleDown[12][2] = {{-1, -2}, {-1, -1}, {-1, 0}, {-1, 1}, {-1, 2}, {0, -2}, {0, -1},
+                                            {0, 1}, {0, 2}, {1, -1}, {1, 0}, {1, 1}};
+    const int (*offsets)[2];
+    int count;
+    if(tiling == TILING_HEX){
+        offsets = i % 2 == 0 ? hexEven : hexOdd;
+        count = 6;
+    }
+    else{
+        offsets = (i + j) % 2 == 0 ? triangleUp : triangleDown;
+        count = 12;
+    }
+
+    int countNeighbour = 0;
+    for(int k = 0; k < count; ++k){
+        int ni = i + offsets[k][0];
+        int nj = j + offsets[k][1];
+        if(map->topology == TOPOLOGY_TORUS){
+            ni = ((ni % map->rows) + map->rows) % map->rows;
+            nj = ((nj % map->cols) + map->cols) % map->cols;
+        }
+        else if(ni < 0 || nj < 0 || ni >= map->rows || nj >= map->cols){
+            continue;
+        }
+        countNeighbour += getCell(map, ni, nj) == ALIVE;
+    }
+    return countNeighbour;
+}
+
+// Neighbours of a Larger-than-Life rule, every cell of the neighbourhood is read. On a torus smaller than the
+// neighbourhood a cell is counted as many times as it appears in it.
+int countRange(const Grid *map, const Rule *rule, int i, int j){
+    int radius = rule->radius;
+    int countNeighbour = 0;
+
+    for(int di = -radius; di <= radius; ++di){
+        int width = rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN ? radius - abs(di) : radius;
+        for(int dj = -width; dj <= width; ++dj){
+            int ni = i + di;
+            int nj = j + dj;
+            if(di == 0 && dj == 0 && !rule->middle){
+                continue;
+            }
+            if(map->topology == TOPOLOGY_TORUS){
+                ni = ((ni % map->rows) + map->rows) % map->rows;
+                nj = ((nj % map->cols) + map->cols) % map->cols;
+            }
+            else if(ni < 0 || nj < 0 || ni >= map->rows || nj >= map->cols){
+                continue;
+            }
+            countNeighbour += getCell(map, ni, nj) == ALIVE;
+        }
+    }
+    return countNeighbour;
+}
+
+// The map is walked tile by tile so that a tiled layout reads and writes whole cache lines
+void updateMap(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule){
+    unsigned long long births = 0, deaths = 0;
+    StepStats stats;
+    emptyStats(&stats, map);
+    int track = state->trackingBounds;
+    TileCounts *tiles = state->tiles;
+    if(tiles != NULL){
+        emptyTiles(tiles, 0, map->rows);
+    }
+
+    perfStart(PERF_COMPUTE);
+    for(int ti = 0; ti < map->rows; ti += TILE_SIZE){
+        for(int tj = 0; tj < map->cols; tj += TILE_SIZE){
+            int endI = ti + TILE_SIZE < map->rows ? ti + TILE_SIZE : map->rows;
+            int endJ = tj + TILE_SIZE < map->cols ? tj + TILE_SIZE : map->cols;
+
+            for(int i = ti; i < endI; ++i){
+                for(int j = tj; j < endJ; ++j){
+                    // /*\ /*\ /*\ /*\ RULES /*\ /*\ /*\ /*\ //
+                    int state = getCell(map, i, j);
+                    int count;
+                    if(rule->radius > 0){
+                        count = countRange(map, rule, i, j);
+                    }
+                    else if(rule->tiling != TILING_SQUARE){
+                        count = countTiling(map, rule->tiling, i, j);
+                    }
+                    else{
+                        count = countNeighbours(map, i, j);
+                    }
+                    int newState = nextState(rule, state, count);
+                    setCell(newMap, i, j, newState);
+                    births += state == DEAD && newState == ALIVE;
+                    deaths += state == ALIVE && newState != ALIVE; // Dying cells of a Generations rule are deaths
+                    if(newState == ALIVE){
+                        stats.population++;
+                        if(track){
+                            addBounds(&stats, i, i, j, j);
+                        }
+                        if(tiles != NULL){
+                            ++*tileCount(tiles, i, j);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    perfStop(PERF_COMPUTE);
+    stats.births = births;
+    stats.deaths = deaths;
+    *bandStats(state, 0) = stats;
+
+    PROF_COUNT(COUNTER_BIRTHS, births);
+    PROF_COUNT(COUNTER_DEATHS, deaths);
+    PROF_COUNT(COUNTER_CELLS, (unsigned long long)map->rows * map->cols);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Lookup-table kernel ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// A 4x4 window is a 16-bit index: bit (4 * row + column). The table gives the central cells (1,1) (1,2) (2,1) (2,2) in bits 0 to 3.
+void initLookupTable(EngineState *state, const Rule *rule){
+    for(unsigned index = 0; index < (1u << 16); ++index){
+        unsigned char block = 0;
+
+        for(int k = 0; k < 4; ++k){
+            int row = 1 + k / 2;
+            int column = 1 + k % 2;
+            int countNeighbour = 0;
+
+            for(int di = -1; di <= 1; ++di){
+                for(int dj = -1; dj <= 1; ++dj){
+                    if(di != 0 || dj != 0){
+                        countNeighbour += (index >> (4 * (row + di) + column + dj)) & 1;
+                    }
+                }
+            }
+            if(nextState(rule, (index >> (4 * row + column)) & 1, countNeighbour) == ALIVE){
+                block |= 1u << k;
+            }
+        }
+        state->lookupTable[index] = block;
+    }
+}
+
+// 4 bits of a padded row starting at padded column p (map column p - 1)
+static unsigned fetchBits(const unsigned long long *row, int p){
+    int word = p / 64;
+    int shift = p % 64;
+    unsigned long long bits = row[word] >> shift;
+    if(shift > 60){
+        bits |= row[word + 1] << (64 - shift);
+    }
+    return (unsigned)(bits & 0xF);
+}
+
+// Compute rows [startRow, endRow) of newMap, startRow is even. The rows are packed one bit per cell in the
+// scratch arena of the band, with one row of halo above and two below: local row r is map row startRow - 1 + r
+// and column j is padded column j + 1. The halo and padding are dead, or copies of the opposite edge on a torus.
+static void lookupBand(const EngineState *state, const Grid *map, Grid *newMap, int startRow, int endRow,
+                       Arena *scratch, StepStats *stats){
+    int cols = map->cols;
+    int words = (cols + 2 + 63) / 64 + 1; // +1 so a 4-bit fetch never overflows
+    int packedCount = endRow - startRow + 3;
+    unsigned long long births = 0, deaths = 0;
+    StepStats counted; // Written to stats once, the bands' statistics share cache lines
+    emptyStats(&counted, map);
+    int track = state->trackingBounds;
+    TileCounts *tiles = state->tiles;
+    const unsigned char *lookupTable = state->lookupTable;
+    size_t packedSize = (size_t)packedCount * words * sizeof(unsigned long long);
+
+    perfStart(PERF_PACK);
+    resetArena(scratch); // Temporary data of the previous generation
+    unsigned long long *packedRows = arenaAlloc(scratch, packedSize, CACHE_LINE);
+    memset(packedRows, 0, packedSize);
+
+    int torus = map->topology == TOPOLOGY_TORUS;
+    for(int r = 0; r < packedCount; ++r){
+        int i = startRow - 1 + r;
+        if(torus){
+            i = (i + map->rows) % map->rows;
+        }
+        else if(i < 0 || i >= map->rows){
+            continue; // Dead padding
+        }
+        unsigned long long *row = packedRows + (size_t)r * words;
+        for(int j = 0; j < cols; ++j){
+            if(getCell(map, i, j) == ALIVE){
+                row[(j + 1) / 64] |= 1ull << ((j + 1) % 64);
+            }
+        }
+        if(torus){
+            row[0] |= (unsigned long long)(getCell(map, i, cols - 1) == ALIVE);
+            row[(cols + 1) / 64] |= (unsigned long long)(getCell(map, i, 0) == ALIVE) << ((cols + 1) % 64);
+        }
+    }
+
+    if(tiles != NULL){
+        emptyTiles(tiles, startRow, endRow);
+    }
+    perfStop(PERF_PACK);
+
+    // Every 2x2 block (i, j) is read from the 4x4 window starting at map cell (i - 1, j - 1)
+    perfStart(PERF_COMPUTE);
+    for(int i = startRow; i < endRow; i += 2){
+        const unsigned long long *window = packedRows + (size_t)(i - startRow) * words;
+        for(int j = 0; j < cols; j += 2){
+            unsigned index = fetchBits(window, j)
+                           | fetchBits(window + words, j) << 4
+                           | fetchBits(window + 2 * words, j) << 8
+                           | fetchBits(window + 3 * words, j) << 12;
+            unsigned block = lookupTable[index];
+            unsigned old = ((index >> 5) & 3) | ((index >> 7) & 0xC); // Central cells (1,1) (1,2) (2,1) (2,2) of the window
+            unsigned inside = 0xF; // Cells of the block that are on the map
+
+            setCell(newMap, i, j, block & 1);
+            if(j + 1 < cols){
+                setCell(newMap, i, j + 1, (block >> 1) & 1);
+            }
+            else{
+                inside &= ~0xAu;
+            }
+            if(i + 1 < endRow){
+                setCell(newMap, i + 1, j, (block >> 2) & 1);
+                if(j + 1 < cols){
+                    setCell(newMap, i + 1, j + 1, (block >> 3) & 1);
+                }
+            }
+            else{
+                inside &= ~0xCu;
+            }
+            births += __builtin_popcount(block & ~old & inside);
+            deaths += __builtin_popcount(old & ~block & inside);
+            unsigned now = block & inside;
+            counted.population += __builtin_popcount(now);
+            if(track && now){
+                // Bits 0 and 1 are row i, bits 0 and 2 column j
+                addBounds(&counted, now & 3 ? i : i + 1, now & 0xC ? i + 1 : i, now & 5 ? j : j + 1, now & 0xA ? j + 1 : j);
+            }
+            if(tiles != NULL){
+                *tileCount(tiles, i, j) += __builtin_popcount(now); // i and j are even, the block is in one tile
+            }
+        }
+    }
+    perfStop(PERF_COMPUTE);
+    counted.births = births;
+    counted.deaths = deaths;
+    *stats = counted;
+
+    PROF_COUNT(COUNTER_BIRTHS, births);
+    PROF_COUNT(COUNTER_DEATHS, deaths);
+    PROF_COUNT(COUNTER_CELLS, (unsigned long long)(endRow - startRow) * cols);
+}
+
+void updateMapLookup(EngineState *state, const Grid *map, Grid *newMap){
+    lookupBand(state, map, newMap, 0, map->rows, engineScratch(state, 0), bandStats(state, 0));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Multithreaded kernel ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+typedef struct StepTask{
+    EngineState *state;
+    const Grid *map;
+    Grid *newMap;
+} StepTask;
+
+static void lookupTask(int band, int startRow, int endRow, void *arg){
+    StepTask *task = arg;
+    lookupBand(task->state, task->map, task->newMap, startRow, endRow, engineScratch(task->state, band),
+               bandStats(task->state, band));
+}
+
+// Lookup-table kernel split in bands between the workers, every band packs its own rows and halo
+void updateMapThreaded(EngineState *state, const Grid *map, Grid *newMap){
+    StepTask task = {state, map, newMap};
+    runWorkerPool(state->pool, lookupTask, map->rows, &task);
+}
+
+// Scratch arena of the thread running band, emptied at every generation
+Arena *engineScratch(EngineState *state, int band){
+    return &state->scratch[band];
+}
@@ -0,0 +1,149 @@
+/*
+    Description:
+        Simulation engine of the game of life. Holds the rule of the game and the different kernels able to
+        compute the next generation of a map:
+            - updateMap():       reference kernel, counts the eight neighbours of every cell one by one.
+            - updateMapLookup(): lookup-table kernel, computes the central 2x2 block of a 4x4 window at once
+                                 from a 64K-entry table built by initLookupTable() for the current rule.
+            - updateMapThreaded(): lookup-table kernel split in row bands between the worker threads (threads.h).
+            - updateMapGenerations(): bit-plane kernel of the multi-state "Generations" rules and of the hexagonal
+                                      and triangular tilings, see generations.c.
+            - updateMapLarger(): Larger-than-Life rules counting the neighbours in a radius up to MAX_RADIUS,
+                                 see larger.c.
+        stepMap() runs the kernel of the selected engine. Generations, hexagonal, triangular and Larger-than-Life
+        rules always go to their own kernel except with the reference engine, which handles every rule cell by cell.
+
+        Hexagonal and triangular maps are stored in the same grids as square ones, one row after the other:
+            - TILING_HEX: odd rows are shifted half a cell to the right, so a cell touches 2 cells of the row
+              above and 2 of the row below (columns j - 1 and j on even rows, j and j + 1 on odd rows).
+            - TILING_TRIANGULAR: cell (i, j) points up when i + j is even, down otherwise, and has the 12 cells
+              sharing one of its corners as neighbours.
+        On a torus the wrap is only seamless with an even number of rows (hexagonal) or columns (triangular).
+
+        Every kernel also counts the population, births and deaths of the generation it computes, from the cells
+        or packed words it already holds (a popcount per word for the bit-parallel kernels), and the bounding box
+        of the alive cells after trackBounds(1). Every band writes its own StepStats (bandStats()) once, stepMap()
+        merges them and stepStats() returns the result.
+
+        Everything an engine keeps between two steps (the lookup table of the rule, the scratch arena and the
+        statistics of every band, the pool of worker threads) lives in an EngineState, so simulations with their
+        own states can step at the same time from different threads. The program uses one state with the pool
+        of the program (initEngineState(&state, programPool())).
+*/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "grid.h"
+#include "threads.h"
+
+#define DEAD 0
+#define ALIVE 1 // States 2 to states - 1 are dying (refractory) cells of a Generations rule
+#define MAX_STATES 16
+#define MAX_RADIUS 10
+#define RULE_TEXT_SIZE 48 // Longest text written by formatRule()
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Rule ~~~~~~~~~~~~~~~~~~~~~~~ //
+typedef enum Tiling{
+    TILING_SQUARE,    // 8 neighbours
+    TILING_HEX,       // 6 neighbours, rule written with a "H" suffix
+    TILING_TRIANGULAR // 12 neighbours, rule written with a "L" suffix, counts 10 to 12 written X, Y and Z
+} Tiling;
+
+typedef enum Neighbourhood{
+    NEIGHBOURHOOD_MOORE,      // Square of side 2 * radius + 1
+    NEIGHBOURHOOD_VON_NEUMANN // Diamond, cells at a Manhattan distance up to radius
+} Neighbourhood;
+
+typedef struct Rule{
+    unsigned short birth;    // Bit n is set if a dead cell with n neighbours becomes alive
+    unsigned short survival; // Bit n is set if an alive cell with n neighbours stays alive
+    unsigned char states;    // 2 for life-like rules, more for Generations rules where an alive cell that doesn't
+                             // survive goes through states 2, 3, ... before being dead again
+    Tiling tiling;
+
+    // Larger-than-Life rules: radius is 0 for the life-like rules above, otherwise the neighbours are counted
+    // in the neighbourhood of that radius and birth / survival are ranges of counts instead of bit masks
+    unsigned char radius;
+    unsigned char middle; // 1 if the cell counts itself
+    Neighbourhood neighbourhood;
+    unsigned short birthMin, birthMax;
+    unsigned short survivalMin, survivalMax;
+} Rule;
+
+#define CONWAY_RULE "B3/S23"
+#define BRIANS_BRAIN_RULE "B2/S/C3"
+#define STAR_WARS_RULE "B2/S345/C4"
+#define BUGS_RULE "R5,C0,M1,S34..58,B34..45,NM"
+#define HEX_RULE "B2/S34H"
+#define TRIANGULAR_RULE "B45/S34L"
+
+int parseRule(const char *text, Rule *rule);
+void formatRule(const Rule *rule, char *text, int size);
+int nextState(const Rule *rule, int state, int countNeighbour);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Statistics ~~~~~~~~~~~~~~~~~~~~~~~ //
+typedef struct StepStats{
+    unsigned long long population; // Alive cells of the new generation, the dying cells of a Generations rule aren't
+    unsigned long long births;
+    unsigned long long deaths;     // Alive cells that aren't alive anymore
+    int minRow, maxRow;            // Bounding box of the alive cells when tracked, minRow > maxRow otherwise or
+    int minCol, maxCol;            // when there are none
+} StepStats;
+
+typedef struct EngineState EngineState;
+
+void trackBounds(EngineState *state, int enabled);
+int boundsTracked(const EngineState *state);
+void trackTiles(EngineState *state, TileCounts *tiles);
+void stepStats(const EngineState *state, StepStats *stats);
+void countStats(const Grid *map, StepStats *stats);
+StepStats *bandStats(EngineState *state, int band);
+
+static inline void emptyStats(StepStats *stats, const Grid *map){
+    *stats = (StepStats){0, 0, 0, map->rows, -1, map->cols, -1};
+}
+
+static inline void addBounds(StepStats *stats, int minRow, int maxRow, int minCol, int maxCol){
+    stats->minRow = minRow < stats->minRow ? minRow : stats->minRow;
+    stats->maxRow = maxRow > stats->maxRow ? maxRow : stats->maxRow;
+    stats->minCol = minCol < stats->minCol ? minCol : stats->minCol;
+    stats->maxCol = maxCol > stats->maxCol ? maxCol : stats->maxCol;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Kernels ~~~~~~~~~~~~~~~~~~~~~~~ //
+typedef enum Engine{
+    ENGINE_REFERENCE,
+    ENGINE_LOOKUP,
+    ENGINE_THREADED
+} Engine;
+
+struct EngineState{
+    unsigned char lookupTable[1 << 16]; // 4x4 window => next state of its central 2x2 block
+    Arena scratch[MAX_WORKERS];         // Temporary data of every band, see engineScratch()
+    StepStats bands[MAX_WORKERS];       // Statistics of every band of the last step, see bandStats()
+    StepStats last;
+    int trackingBounds;
+    TileCounts *tiles;                  // Alive cells of every tile of the new generation, see trackTiles()
+    WorkerPool *pool;                   // Runs the bands of the threaded kernels
+};
+
+int parseEngine(const char *text, Engine *engine);
+void initEngineState(EngineState *state, WorkerPool *pool);
+void freeEngineState(EngineState *state);
+void initEngine(EngineState *state, Engine engine, const Rule *rule);
+void stepMap(EngineState *state, Engine engine, const Grid *map, Grid *newMap, const Rule *rule);
+
+// Every kernel reads map and writes the next generation in newMap, both grids have the same dimensions
+int countNeighbours(const Grid *map, int i, int j);
+int countTiling(const Grid *map, Tiling tiling, int i, int j);
+void updateMap(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule);
+void initLookupTable(EngineState *state, const Rule *rule);
+void updateMapLookup(EngineState *state, const Grid *map, Grid *newMap);
+void updateMapThreaded(EngineState *state, const Grid *map, Grid *newMap);
+void updateMapGenerations(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule, int threaded);
+int countRange(const Grid *map, const Rule *rule, int i, int j);
+void updateMapLarger(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule, int threaded);
+Arena *engineScratch(EngineState *state, int band);
+
+#endif
@@ -0,0 +1,369 @@
+/*
+    Description:
+        Export of generations as images (see export.h).
+
+    Sources:
+        https://www.w3.org/Graphics/GIF/spec-gif89a.txt
+        https://www.w3.org/TR/png/
+        https://www.rfc-editor.org/rfc/rfc1950
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "export.h"
+
+#define LZW_MIN_CODE_SIZE 2 // The smallest GIF allows, 4 colours
+#define LZW_CLEAR 4
+#define LZW_END 5
+#define LZW_MAX_CODES 4096
+#define STORED_BLOCK 65535  // Largest stored deflate block
+
+static const unsigned char palette[4][3] = {{0x20, 0x20, 0x20}, {0xF0, 0xF0, 0xF0}, {0, 0, 0}, {0, 0, 0}};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Pixels ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// One pixel per byte, 0 dead and 1 alive, for the cells of row i
+static void pixelRow(const Exporter *exporter, const BitGrid *bits, int i, unsigned char *pixels){
+    const unsigned long long *row = bitRow(bits, i);
+    for(int j = 0; j < bits->cols; ++j){
+        memset(pixels + (size_t)j * exporter->scale, (int)((row[j >> 6] >> (j & 63)) & 1), exporter->scale);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ GIF ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static void writeShort(FILE *file, int value){
+    fputc(value & 0xFF, file);
+    fputc((value >> 8) & 0xFF, file);
+}
+
+static void gifHeader(Exporter *exporter){
+    FILE *gif = exporter->gif;
+    fwrite("GIF89a", 1, 6, gif);
+    writeShort(gif, exporter->width);
+    writeShort(gif, exporter->height);
+    fputc(0x80 | (LZW_MIN_CODE_SIZE - 1) << 4 | (LZW_MIN_CODE_SIZE - 1), gif); // Global table of 4 colours
+    fputc(0, gif); // Background colour
+    fputc(0, gif); // Square pixels
+    fwrite(palette, 1, sizeof(palette), gif);
+    fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, gif); // Loop forever
+}
+
+typedef struct BitWriter{
+    unsigned char *out;
+    size_t size;
+    unsigned long long pending; // Bits not written yet, LSB first
+    int count;
+} BitWriter;
+
+static void writeCode(BitWriter *writer, unsigned code, int size){
+    writer->pending |= (unsigned long long)code << writer->count;
+    writer->count += size;
+    while(writer->count >= 8){
+        writer->out[writer->size++] = (unsigned char)writer->pending;
+        writer->pending >>= 8;
+        writer->count -= 8;
+    }
+}
+
+// The dictionary is a tree: child[code][pixel] is the code of string code + pixel, pixels are only 0 or 1
+static void gifFrame(Exporter *exporter, const ExportFrame *frame){
+    unsigned short (*child)[2] = exporter->dictionary;
+    size_t dictionarySize = LZW_MAX_CODES * sizeof(*child);
+    BitWriter writer = {exporter->encoded, 0, 0, 0};
+    int codeSize = LZW_MIN_CODE_SIZE + 1;
+    unsigned next = LZW_END + 1;
+    int prefix = -1;
+
+    memset(child, 0, dictionarySize); // 0 is never a child, the first free code is LZW_END + 1
+    writeCode(&writer, LZW_CLEAR, codeSize);
+    for(int i = 0; i < frame->bits.rows; ++i){
+        pixelRow(exporter, &frame->bits, i, exporter->pixels);
+        for(int repeat = 0; repeat < exporter->scale; ++repeat){
+            for(int x = 0; x < exporter->width; ++x){
+                int pixel = exporter->pixels[x];
+                if(prefix < 0){
+                    prefix = pixel;
+                }
+                else if(child[prefix][pixel] != 0){
+                    prefix = child[prefix][pixel];
+                }
+                else{
+                    writeCode(&writer, (unsigned)prefix, codeSize);
+                    if(next < LZW_MAX_CODES){
+                        child[prefix][pixel] = (unsigned short)next++;
+                        // The decoder adds its entries a code late, it grows the codes when next - 1 needs a bit more
+                        if(next > (1u << codeSize) && codeSize < 12){
+                            codeSize++;
+                        }
+                    }
+                    else{
+                        writeCode(&writer, LZW_CLEAR, codeSize);
+                        memset(child, 0, dictionarySize);
+                        codeSize = LZW_MIN_CODE_SIZE + 1;
+                        next = LZW_END + 1;
+                    }
+                    prefix = pixel;
+                }
+            }
+        }
+    }
+    writeCode(&writer, (unsigned)prefix, codeSize);
+    writeCode(&writer, LZW_END, codeSize);
+    writeCode(&writer, 0, 7); // Flush the last byte
+
+    FILE *gif = exporter->gif;
+    fwrite("\x21\xF9\x04\x00", 1, 4, gif); // Graphic control: no transparency
+    writeShort(gif, exporter->delay);
+    fputc(0, gif);
+    fputc(0, gif);
+    fputc(0x2C, gif); // Image descriptor, the whole screen
+    writeShort(gif, 0);
+    writeShort(gif, 0);
+    writeShort(gif, exporter->width);
+    writeShort(gif, exporter->height);
+    fputc(0, gif);
+    fputc(LZW_MIN_CODE_SIZE, gif);
+    for(size_t start = 0; start < writer.size; start += 255){ // Sub-blocks of at most 255 bytes
+        size_t length = writer.size - start < 255 ? writer.size - start : 255;
+        fputc((int)length, gif);
+        fwrite(writer.out + start, 1, length, gif);
+    }
+    fputc(0, gif);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ PNG ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static unsigned crc32(unsigned crc, const unsigned char *data, size_t size){
+    static unsigned table[256];
+    if(table[1] == 0){
+        for(unsigned n = 0; n < 256; ++n){
+            unsigned c = n;
+            for(int k = 0; k < 8; ++k){
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+    crc = ~crc;
+    for(size_t k = 0; k < size; ++k){
+        crc = table[(crc ^ data[k]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void putBig(unsigned char *out, unsigned value){
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+static void pngChunk(FILE *png, const char *type, const unsigned char *data, size_t size){
+    unsigned char bytes[4];
+    putBig(bytes, (unsigned)size);
+    fwrite(bytes, 1, 4, png);
+    fwrite(type, 1, 4, png);
+    if(size > 0){
+        fwrite(data, 1, size, png); // IEND has no data
+    }
+    putBig(bytes, crc32(crc32(0, (const unsigned char *)type, 4), data, size));
+    fwrite(bytes, 1, 4, png);
+}
+
+static size_t pngStride(const Exporter *exporter){
+    return 1 + ((size_t)exporter->width + 7) / 8; // Filter byte, then 8 pixels per byte, the first in the high bit
+}
+
+static size_t pngBound(const Exporter *exporter){
+    size_t raw = pngStride(exporter) * exporter->height;
+    return 2 + raw + 5 * (raw / STORED_BLOCK + 1) + 4;
+}
+
+static void pngFrame(Exporter *exporter, const ExportFrame *frame){
+    char path[EXPORT_PATH_SIZE + 32];
+    snprintf(path, sizeof(path), "%.*s-%06lld.png", (int)strlen(exporter->path) - 4, exporter->path, frame->generation);
+    FILE *png = fopen(path, "wb");
+    if(png == NULL){
+        return;
+    }
+
+    // Raw scanlines after the zlib header, the stored block headers are inserted afterwards
+    size_t stride = pngStride(exporter);
+    size_t raw = stride * exporter->height;
+    size_t blocks = raw / STORED_BLOCK + 1;
+    unsigned char *data = exporter->encoded + 2 + 5 * blocks;
+    for(int i = 0; i < frame->bits.rows; ++i){
+        pixelRow(exporter, &frame->bits, i, exporter->pixels);
+        unsigned char *line = data + (size_t)i * exporter->scale * stride;
+        memset(line, 0, stride);
+        for(int x = 0; x < exporter->width; ++x){
+            line[1 + x / 8] |= (unsigned char)(exporter->pixels[x] << (7 - x % 8));
+        }
+        for(int repeat = 1; repeat < exporter->scale; ++repeat){
+            memcpy(line + repeat * stride, line, stride);
+        }
+    }
+
+    unsigned a = 1, b = 0; // Adler-32 of the raw data
+    for(size_t k = 0; k < raw; ++k){
+        a = (a + data[k]) % 65521;
+        b = (b + a) % 65521;
+    }
+    unsigned char *out = exporter->encoded;
+    size_t size = 0;
+    out[size++] = 0x78; // Deflate, 32K window, no dictionary
+    out[size++] = 0x01;
+    for(size_t start = 0; start < raw; start += STORED_BLOCK){
+        size_t length = raw - start < STORED_BLOCK ? raw - start : STORED_BLOCK;
+        out[size++] = start + length == raw; // Final block flag, stored type
+        out[size++] = (unsigned char)length;
+        out[size++] = (unsigned char)(length >> 8);
+        out[size++] = (unsigned char)~length;
+        out[size++] = (unsigned char)(~length >> 8);
+        memmove(out + size, data + start, length);
+        size += length;
+    }
+    putBig(out + size, b << 16 | a);
+    size += 4;
+
+    fwrite("\x89PNG\r\n\x1A\n", 1, 8, png);
+    unsigned char header[13];
+    putBig(header, (unsigned)exporter->width);
+    putBig(header + 4, (unsigned)exporter->height);
+    header[8] = 1;  // Bits per pixel
+    header[9] = 3;  // Indexed colours
+    header[10] = 0; // Deflate
+    header[11] = 0; // Adaptive filters, all of them none
+    header[12] = 0; // Not interlaced
+    pngChunk(png, "IHDR", header, sizeof(header));
+    pngChunk(png, "PLTE", &palette[0][0], 6);
+    pngChunk(png, "IDAT", out, size);
+    pngChunk(png, "IEND", NULL, 0);
+    fclose(png);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Queue ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static void *encoderLoop(void *arg){
+    Exporter *exporter = arg;
+    pthread_mutex_lock(&exporter->lock);
+    while(1){
+        while(exporter->count == 0 && !exporter->closing){
+            pthread_cond_wait(&exporter->frameReady, &exporter->lock);
+        }
+        if(exporter->count == 0){
+            break; // Closing and every frame is written
+        }
+        ExportFrame *frame = &exporter->frames[exporter->head];
+        pthread_mutex_unlock(&exporter->lock);
+
+        if(exporter->format == EXPORT_GIF){
+            gifFrame(exporter, frame);
+        }
+        else{
+            pngFrame(exporter, frame);
+        }
+        exporter->written++;
+
+        pthread_mutex_lock(&exporter->lock);
+        exporter->head = (exporter->head + 1) % EXPORT_QUEUE;
+        exporter->count--;
+        pthread_cond_signal(&exporter->slotFree);
+    }
+    pthread_mutex_unlock(&exporter->lock);
+    return NULL;
+}
+
+// Return 1 on success, 0 if the path has no known extension or can't be written
+int openExporter(Exporter *exporter, const char *path, int rows, int cols, const ExportOptions *options, Arena *arena,
+                 WorkerPool *pool){
+    size_t length = strlen(path);
+    if(length < 4 || length >= EXPORT_PATH_SIZE || options->scale < 1 || options->every < 1){
+        return 0;
+    }
+    if(strcmp(path + length - 4, ".gif") == 0){
+        exporter->format = EXPORT_GIF;
+    }
+    else if(strcmp(path + length - 4, ".png") == 0){
+        exporter->format = EXPORT_PNG;
+    }
+    else{
+        return 0;
+    }
+    snprintf(exporter->path, sizeof(exporter->path), "%s", path);
+    exporter->scale = options->scale;
+    exporter->delay = (options->delay + 5) / 10;
+    exporter->every = options->every;
+    exporter->width = cols * options->scale;
+    exporter->height = rows * options->scale;
+    exporter->pool = pool;
+    if(exporter->width > 0xFFFF || exporter->height > 0xFFFF){
+        return 0; // Larger than a GIF screen
+    }
+    exporter->gif = NULL;
+    if(exporter->format == EXPORT_GIF){
+        exporter->gif = fopen(path, "wb");
+        if(exporter->gif == NULL){
+            return 0;
+        }
+        gifHeader(exporter);
+    }
+
+    // Codes of at most 12 bits for every pixel in the worst case, or the stored PNG data
+    size_t gifBound = (size_t)exporter->width * exporter->height * 2 + 64;
+    exporter->encodedSize = exporter->format == EXPORT_GIF ? gifBound : pngBound(exporter);
+    exporter->encoded = arenaAlloc(arena, exporter->encodedSize, CACHE_LINE);
+    exporter->pixels = arenaAlloc(arena, exporter->width, CACHE_LINE);
+    exporter->dictionary = arenaAlloc(arena, LZW_MAX_CODES * sizeof(*exporter->dictionary), CACHE_LINE);
+    for(int k = 0; k < EXPORT_QUEUE; ++k){
+        createBitGrid(&exporter->frames[k].bits, rows, cols, arena);
+    }
+    exporter->head = 0;
+    exporter->count = 0;
+    exporter->closing = 0;
+    exporter->written = 0;
+    pthread_mutex_init(&exporter->lock, NULL);
+    pthread_cond_init(&exporter->frameReady, NULL);
+    pthread_cond_init(&exporter->slotFree, NULL);
+    if(pthread_create(&exporter->thread, NULL, encoderLoop, exporter) != 0){
+        printf("\nERROR: openExporter() function => pthread_create failed\n");
+        exit(1);
+    }
+    return 1;
+}
+
+// Queue a copy of the map, wait for a free slot when the encoder is EXPORT_QUEUE frames late
+void exportFrame(Exporter *exporter, const Grid *map, long long generation){
+    if(generation % exporter->every != 0){
+        return;
+    }
+    pthread_mutex_lock(&exporter->lock);
+    while(exporter->count == EXPORT_QUEUE){
+        pthread_cond_wait(&exporter->slotFree, &exporter->lock);
+    }
+    ExportFrame *frame = &exporter->frames[(exporter->head + exporter->count) % EXPORT_QUEUE];
+    pthread_mutex_unlock(&exporter->lock);
+
+    packGrid(map, &frame->bits, exporter->pool); // The encoder never reads a free slot
+    frame->generation = generation;
+
+    pthread_mutex_lock(&exporter->lock);
+    exporter->count++;
+    pthread_cond_signal(&exporter->frameReady);
+    pthread_mutex_unlock(&exporter->lock);
+}
+
+// Write the frames still queued and the end of the GIF
+void closeExporter(Exporter *exporter){
+    pthread_mutex_lock(&exporter->lock);
+    exporter->closing = 1;
+    pthread_cond_signal(&exporter->frameReady);
+    pthread_mutex_unlock(&exporter->lock);
+    pthread_join(exporter->thread, NULL);
+    if(exporter->gif != NULL){
+        fputc(0x3B, exporter->gif); // Trailer
+        fclose(exporter->gif);
+        exporter->gif = NULL;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+    Description:
+        Export of generations as images, without a terminal. exportFrame() only packs the map one bit per cell
+        into a free slot of a bounded queue of EXPORT_QUEUE frames (it waits when the queue is full); an encoder
+        thread turns the queued frames into images, so the simulation only pays for the packing.
+
+        Formats, chosen from the extension of the path:
+            - .gif: one animated GIF, every frame shown for the delay given to openExporter(), looping forever.
+              The pixels are LZW-compressed as usual with a 4-colour table (dead, alive and two unused).
+            - .png: one indexed-colour PNG of 1 bit per pixel per frame, named <path without .png>-<generation>.png.
+              The image data is stored in uncompressed deflate blocks, so no zlib is needed.
+        Only the generations multiple of every are exported, the others are skipped by exportFrame(). Every cell
+        is drawn as a square of scale x scale pixels. Only alive cells are drawn, the dying cells of a
+        Generations rule are dead.
+
+    Sources:
+        https://www.w3.org/Graphics/GIF/spec-gif89a.txt
+        https://www.w3.org/TR/png/
+        https://www.rfc-editor.org/rfc/rfc1950 (zlib stream) and rfc1951 (stored deflate blocks)
+*/
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include "grid.h"
+
+#define EXPORT_QUEUE 8
+#define EXPORT_PATH_SIZE 256
+#define EXPORT_SCALE 4  // Pixels per cell side by default
+#define EXPORT_DELAY 50 // Milliseconds per GIF frame by default
+
+typedef struct ExportOptions{
+    int scale; // Pixels per cell side
+    int delay; // Milliseconds per GIF frame
+    int every; // Generations between two frames
+} ExportOptions;
+
+typedef enum ExportFormat{
+    EXPORT_GIF,
+    EXPORT_PNG
+} ExportFormat;
+
+typedef struct ExportFrame{
+    BitGrid bits;
+    long long generation;
+} ExportFrame;
+
+typedef struct Exporter{
+    ExportFormat format;
+    char path[EXPORT_PATH_SIZE];
+    int scale;
+    int delay;        // Hundredths of a second per GIF frame
+    int every;
+    FILE *gif;
+    int width;        // Pixels
+    int height;
+    WorkerPool *pool; // Packs the frames
+
+    ExportFrame frames[EXPORT_QUEUE]; // Ring of frames waiting for the encoder
+    int head;         // Next frame to encode
+    int count;
+    int closing;
+    pthread_mutex_t lock;
+    pthread_cond_t frameReady;
+    pthread_cond_t slotFree;
+    pthread_t thread;
+
+    unsigned char *pixels;  // Encoder thread only: a row of pixels, then the image data being built
+    unsigned char *encoded;
+    unsigned short (*dictionary)[2]; // LZW codes of a string followed by a 0 or a 1 pixel
+    size_t encodedSize;
+    long long written;      // Frames encoded
+} Exporter;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int openExporter(Exporter *exporter, const char *path, int rows, int cols, const ExportOptions *options, Arena *arena,
+                 WorkerPool *pool);
+void exportFrame(Exporter *exporter, const Grid *map, long long generation);
+void closeExporter(Exporter *exporter);
+
+#endif
@@ -0,0 +1,409 @@
+/*
+    Description:
+        Bit-plane kernel of the Generations rules and of the hexagonal and triangular tilings (see engine.h).
+        With a Generations rule a cell that stops being alive goes through the dying states 2, 3, ...,
+        states - 1 before being dead again. Only alive cells are counted as neighbours and dying cells can't be
+        born, so a step is a life-like step plus a counter for the dying cells.
+        The band is stored as bit planes, 64 cells per word:
+            - the alive plane, with one row of halo above and below, is what the neighbours are counted from;
+            - the state planes hold bit k of the state of every cell in plane k, 2 planes for 3 or 4 states up
+              to 4 planes for 16 states, instead of one byte per cell.
+        The planes only live for one step: the map stays one byte per cell for the renderer, the history and
+        the editing commands, so every step packs the band into planes and unpacks the new states (PERF_PACK).
+        On a row-major map 8 cells are transcoded at once, one 64-bit word of bytes to 8 bits of every plane
+        with a multiplication and back.
+        The neighbour count of 64 cells at once is a 4-bit number spread over 4 words, built with full adders.
+        Every neighbour of the 64 cells is the same row shifted by a few bits: for the hexagonal tiling the
+        shifts depend on the parity of the row, for the triangular one the up and down cells of a row share
+        10 neighbours and an even / odd column mask picks the 2 they don't.
+
+    Sources:
+        https://conwaylife.com/wiki/Generations
+        http://www.graphics.stanford.edu/~seander/bithacks.html
+*/
+
+#include <string.h>
+#include "engine.h"
+#include "perf.h"
+#include "prof.h"
+#include "threads.h"
+
+#define MAX_PLANES 4 // Enough for MAX_STATES states
+#define PADDING 2    // Padded columns on both sides, the triangular neighbourhood is 5 cells wide
+
+typedef struct GenerationsTask{
+    EngineState *state;
+    const Grid *map;
+    Grid *newMap;
+    const Rule *rule;
+} GenerationsTask;
+
+// Number of state planes needed to write the states 0 to states - 1
+static int statePlanes(int states){
+    int planes = 1;
+    while((1 << planes) < states){
+        planes++;
+    }
+    return planes;
+}
+
+// Cells of the word whose 4-bit neighbour count is in counts, a mask of neighbour counts like Rule.birth
+static unsigned long long countIn(const unsigned long long count[4], unsigned short counts){
+    unsigned long long match = 0;
+    for(int n = 0; n <= 12; ++n){
+        if((counts >> n) & 1){
+            unsigned long long equal = ~0ull;
+            for(int k = 0; k < 4; ++k){
+                equal &= (n >> k) & 1 ? count[k] : ~count[k];
+            }
+            match |= equal;
+        }
+    }
+    return match;
+}
+
+// Bits of the cells shift columns to the right of the 64 cells of word w (to the left when shift < 0)
+static inline unsigned long long shifted(const unsigned long long *line, int w, int words, int shift){
+    if(shift > 0){
+        return line[w] >> shift | (w + 1 < words ? line[w + 1] << (64 - shift) : 0);
+    }
+    if(shift < 0){
+        return line[w] << -shift | (w > 0 ? line[w - 1] >> (64 + shift) : 0);
+    }
+    return line[w];
+}
+
+// Add the 64 bits of x to the 4-bit counts
+static inline void addBits(unsigned long long count[4], unsigned long long x){
+    for(int k = 0; k < 4; ++k){
+        unsigned long long carry = count[k] & x;
+        count[k] ^= x;
+        x = carry;
+    }
+}
+
+// Neighbour count of the 64 cells of word w of a row, rows above / below being the halo of the band
+static void countWord(const unsigned long long *up, const unsigned long long *row, const unsigned long long *down,
+                      int w, int words, unsigned long long count[4]){
+    const unsigned long long *lines[3] = {up, row, down};
+    unsigned long long left[3], right[3];
+    for(int k = 0; k < 3; ++k){
+        left[k] = shifted(lines[k], w, words, -1);  // Cell on the left of every cell
+        right[k] = shifted(lines[k], w, words, 1);  // Cell on the right of every cell
+    }
+
+    // Sums of the 3 cells above, of the 3 cells below and of the 2 cells beside, 2 bits each
+    unsigned long long a0 = left[0] ^ up[w] ^ right[0];
+    unsigned long long a1 = (left[0] & up[w]) | (right[0] & (left[0] ^ up[w]));
+    unsigned long long b0 = left[2] ^ down[w] ^ right[2];
+    unsigned long long b1 = (left[2] & down[w]) | (right[2] & (left[2] ^ down[w]));
+    unsigned long long c0 = left[1] ^ right[1];
+    unsigned long long c1 = left[1] & right[1];
+
+    // a + b, 0 to 6 on 3 bits
+    unsigned long long s0 = a0 ^ b0;
+    unsigned long long carry = a0 & b0;
+    unsigned long long s1 = a1 ^ b1 ^ carry;
+    unsigned long long s2 = (a1 & b1) | (carry & (a1 ^ b1));
+
+    // + c, 0 to 8 on 4 bits
+    count[0] = s0 ^ c0;
+    carry = s0 & c0;
+    count[1] = s1 ^ c1 ^ carry;
+    carry = (s1 & c1) | (carry & (s1 ^ c1));
+    count[2] = s2 ^ carry;
+    count[3] = s2 & carry;
+}
+
+// Same for the hexagonal tiling, i is the map row of the cells
+static void countHexWord(const unsigned long long *up, const unsigned long long *row, const unsigned long long *down,
+                         int w, int words, int i, unsigned long long count[4]){
+    int shift = i % 2 == 0 ? -1 : 1; // Second cell of the rows above and below
+    memset(count, 0, 4 * sizeof(unsigned long long));
+    addBits(count, shifted(row, w, words, -1));
+    addBits(count, shifted(row, w, words, 1));
+    addBits(count, up[w]);
+    addBits(count, shifted(up, w, words, shift));
+    addBits(count, down[w]);
+    addBits(count, shifted(down, w, words, shift));
+}
+
+// Same for the triangular tiling, i is the map row of the cells
+static void countTriangularWord(const unsigned long long *up, const unsigned long long *row,
+                                const unsigned long long *down, int w, int words, int i, unsigned long long count[4]){
+    // Padded column p is map column p - PADDING, cells pointing up are the ones with i + p even
+    unsigned long long pointingUp = (i + PADDING) % 2 == 0 ? 0x5555555555555555ull : 0xAAAAAAAAAAAAAAAAull;
+    memset(count, 0, 4 * sizeof(unsigned long long));
+    for(int shift = -2; shift <= 2; ++shift){
+        if(shift != 0){
+            addBits(count, shifted(row, w, words, shift));
+        }
+        if(shift >= -1 && shift <= 1){
+            addBits(count, shifted(up, w, words, shift));
+            addBits(count, shifted(down, w, words, shift));
+        }
+        else{
+            addBits(count, shifted(down, w, words, shift) & pointingUp);  // The base of an up cell is below
+            addBits(count, shifted(up, w, words, shift) & ~pointingUp);   // The base of a down cell is above
+        }
+    }
+}
+
+// Add the alive cells of word w (padded columns) of row i to their tiles, a tile at a time
+static void countWordTiles(TileCounts *tiles, int i, int w, unsigned long long now){
+    while(now != 0){
+        int j = 64 * w + __builtin_ctzll(now) - PADDING;
+        int end = ((j >> TILE_SHIFT) + 1) * TILE_SIZE + PADDING - 64 * w; // First bit of the next tile
+        unsigned long long inTile = end >= 64 ? now : now & ((1ull << end) - 1);
+        *tileCount(tiles, i, j) += __builtin_popcountll(inTile);
+        now &= ~inTile;
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Transcoding ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BYTE_CELLS 1 // 8 cells of a row-major map are read and written as one word, cell j in byte j % 8
+#else
+#define BYTE_CELLS 0
+#endif
+#define LOW_BITS 0x0101010101010101ull // Bit 0 of every byte
+
+// Bit k of the states of 8 cells, bit i for byte i: the multiplication moves bit 0 of byte i to bit 56 + i
+static inline unsigned gatherBits(unsigned long long cells, int k){
+    return (unsigned)((((cells >> k) & LOW_BITS) * 0x0102040810204080ull) >> 56);
+}
+
+// Bit i of the 8 bits to bit 0 of byte i: byte i of the copies keeps bit i, adding 0x7F carries it to bit 7
+static inline unsigned long long spreadBits8(unsigned bits){
+    unsigned long long kept = (bits * LOW_BITS) & 0x8040201008040201ull;
+    return ((kept + 0x7F7F7F7F7F7F7F7Full) >> 7) & LOW_BITS;
+}
+
+// The 8 bits of a line of words from bit p
+static inline unsigned bitsAt(const unsigned long long *line, int p){
+    unsigned long long bits = line[p / 64] >> (p % 64);
+    if(p % 64 > 56){
+        bits |= line[p / 64 + 1] << (64 - p % 64);
+    }
+    return (unsigned)(bits & 0xFF);
+}
+
+static inline void orBitsAt(unsigned long long *line, int p, unsigned bits){
+    line[p / 64] |= (unsigned long long)bits << (p % 64);
+    if(p % 64 > 56){
+        line[p / 64 + 1] |= (unsigned long long)bits >> (64 - p % 64);
+    }
+}
+
+// Add the alive cells of map row i to the alive line and, if states isn't NULL, the bits of their states to
+// the state lines, map column j on padded column j + PADDING
+static void packRow(const Grid *map, int i, int planes, unsigned long long *aliveLine, unsigned long long **states){
+    int j = 0;
+    if(BYTE_CELLS && map->layout == LAYOUT_ROW_MAJOR){
+        const unsigned char *cells = map->cells + (size_t)i * map->cols;
+        for(; j + 8 <= map->cols; j += 8){
+            unsigned long long eight;
+            memcpy(&eight, cells + j, sizeof(eight));
+            // State 1: bit 0 set and the 7 other bits of the byte clear
+            unsigned long long high = (eight >> 1) & 0x7F7F7F7F7F7F7F7Full;
+            unsigned long long highSet = (((high + 0x7F7F7F7F7F7F7F7Full) | high) >> 7) & LOW_BITS;
+            orBitsAt(aliveLine, j + PADDING, gatherBits(eight & ~highSet, 0));
+            for(int k = 0; states != NULL && k < planes; ++k){
+                orBitsAt(states[k], j + PADDING, gatherBits(eight, k));
+            }
+        }
+    }
+    for(; j < map->cols; ++j){
+        int cell = getCell(map, i, j);
+        int p = j + PADDING;
+        if(cell == ALIVE){
+            aliveLine[p / 64] |= 1ull << (p % 64);
+        }
+        for(int k = 0; states != NULL && k < planes; ++k){
+            states[k][p / 64] |= (unsigned long long)((cell >> k) & 1) << (p % 64);
+        }
+    }
+}
+
+// Write map row i from the state lines
+static void unpackRow(Grid *map, int i, int planes, const unsigned long long **states){
+    int j = 0;
+    if(BYTE_CELLS && map->layout == LAYOUT_ROW_MAJOR){
+        unsigned char *cells = map->cells + (size_t)i * map->cols;
+        for(; j + 8 <= map->cols; j += 8){
+            unsigned long long eight = 0;
+            for(int k = 0; k < planes; ++k){
+                eight |= spreadBits8(bitsAt(states[k], j + PADDING)) << k;
+            }
+            memcpy(cells + j, &eight, sizeof(eight));
+        }
+    }
+    for(; j < map->cols; ++j){
+        int p = j + PADDING;
+        int cell = 0;
+        for(int k = 0; k < planes; ++k){
+            cell |= (int)((states[k][p / 64] >> (p % 64)) & 1) << k;
+        }
+        setCell(map, i, j, cell);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Kernel ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Compute rows [startRow, endRow) of newMap. Local row r of the alive plane is map row startRow - 1 + r and column
+// j is padded column j + PADDING. The state planes only hold the rows of the band.
+static void generationsBand(const EngineState *engineState, const Grid *map, Grid *newMap, const Rule *rule,
+                            int startRow, int endRow, Arena *scratch, StepStats *stats){
+    int cols = map->cols;
+    int words = (cols + 2 * PADDING + 63) / 64;
+    int bandRows = endRow - startRow;
+    int planes = statePlanes(rule->states);
+    unsigned long long births = 0, deaths = 0;
+    StepStats counted; // Written to stats once, the bands' statistics share cache lines
+    emptyStats(&counted, map);
+    int track = engineState->trackingBounds;
+    TileCounts *tiles = engineState->tiles;
+    size_t aliveSize = (size_t)(bandRows + 2) * words * sizeof(unsigned long long);
+    size_t planeSize = (size_t)bandRows * words * sizeof(unsigned long long);
+
+    perfStart(PERF_PACK);
+    resetArena(scratch); // Temporary data of the previous generation
+    unsigned long long *alive = arenaAlloc(scratch, aliveSize, CACHE_LINE);
+    unsigned long long *state[MAX_PLANES];
+    memset(alive, 0, aliveSize);
+    for(int k = 0; k < planes; ++k){
+        state[k] = arenaAlloc(scratch, planeSize, CACHE_LINE);
+        memset(state[k], 0, planeSize);
+    }
+
+    int torus = map->topology == TOPOLOGY_TORUS;
+    for(int r = 0; r < bandRows + 2; ++r){
+        int i = startRow - 1 + r;
+        if(torus){
+            i = (i + map->rows) % map->rows;
+        }
+        else if(i < 0 || i >= map->rows){
+            continue; // Dead padding
+        }
+        int inBand = r >= 1 && r <= bandRows;
+        unsigned long long *row = alive + (size_t)r * words;
+        unsigned long long *rowStates[MAX_PLANES];
+        for(int k = 0; k < planes; ++k){
+            rowStates[k] = state[k] + (size_t)(r - 1) * words;
+        }
+        packRow(map, i, planes, row, inBand ? rowStates : NULL);
+        for(int k = 1; torus && k <= PADDING; ++k){
+            int left = PADDING - k;
+            int right = cols + PADDING - 1 + k;
+            row[left / 64] |= (unsigned long long)(getCell(map, i, ((cols - k) % cols + cols) % cols) == ALIVE) << (left % 64);
+            row[right / 64] |= (unsigned long long)(getCell(map, i, (k - 1) % cols) == ALIVE) << (right % 64);
+        }
+    }
+    if(tiles != NULL){
+        emptyTiles(tiles, startRow, endRow);
+    }
+    perfStop(PERF_PACK);
+
+    perfStart(PERF_COMPUTE);
+    for(int r = 0; r < bandRows; ++r){
+        const unsigned long long *up = alive + (size_t)r * words;
+        const unsigned long long *row = up + words;
+        const unsigned long long *down = row + words;
+        int i = startRow + r;
+        for(int w = 0; w < words; ++w){
+            unsigned long long count[4];
+            if(rule->tiling == TILING_HEX){
+                countHexWord(up, row, down, w, words, i, count);
+            }
+            else if(rule->tiling == TILING_TRIANGULAR){
+                countTriangularWord(up, row, down, w, words, i, count);
+            }
+            else{
+                countWord(up, row, down, w, words, count);
+            }
+
+            unsigned long long *s[MAX_PLANES];
+            unsigned long long any = 0;
+            for(int k = 0; k < planes; ++k){
+                s[k] = state[k] + (size_t)r * words + w;
+                any |= *s[k];
+            }
+            unsigned long long wasAlive = row[w];
+            unsigned long long born = ~any & countIn(count, rule->birth);
+            unsigned long long survive = wasAlive & countIn(count, rule->survival);
+
+            // Every cell that isn't dead nor surviving moves to the next state: alive to 2, dying k to k + 1
+            unsigned long long carry = any & ~survive;
+            unsigned long long last = ~0ull; // Cells whose new state is states, they wrap to dead
+            for(int k = 0; k < planes; ++k){
+                unsigned long long bit = *s[k];
+                *s[k] = bit ^ carry;
+                carry &= bit;
+                last &= ((rule->states >> k) & 1) ? *s[k] : ~*s[k];
+            }
+            for(int k = 0; k < planes; ++k){
+                *s[k] &= ~last;
+            }
+            *s[0] |= born;
+
+            unsigned long long valid = ~0ull; // Padded columns PADDING to cols + PADDING - 1
+            if(w == 0){
+                valid &= ~0ull << PADDING;
+            }
+            if(w == (cols + PADDING) / 64){
+                valid &= ~(~0ull << ((cols + PADDING) % 64));
+            }
+            else if(w > (cols + PADDING) / 64){
+                valid = 0;
+            }
+            births += __builtin_popcountll(born & valid);
+            deaths += __builtin_popcountll(wasAlive & ~survive & valid);
+            unsigned long long now = (born | survive) & valid; // Alive cells of the new generation
+            counted.population += __builtin_popcountll(now);
+            if(track && now){
+                addBounds(&counted, i, i, 64 * w + __builtin_ctzll(now) - PADDING, 64 * w + 63 - __builtin_clzll(now) - PADDING);
+            }
+            if(tiles != NULL){
+                countWordTiles(tiles, i, w, now);
+            }
+        }
+    }
+
+    perfStop(PERF_COMPUTE);
+
+    perfStart(PERF_PACK);
+    for(int r = 0; r < bandRows; ++r){
+        const unsigned long long *rowStates[MAX_PLANES];
+        for(int k = 0; k < planes; ++k){
+            rowStates[k] = state[k] + (size_t)r * words;
+        }
+        unpackRow(newMap, startRow + r, planes, rowStates);
+    }
+    perfStop(PERF_PACK);
+
+    counted.births = births;
+    counted.deaths = deaths;
+    *stats = counted;
+
+    PROF_COUNT(COUNTER_BIRTHS, births);
+    PROF_COUNT(COUNTER_DEATHS, deaths);
+    PROF_COUNT(COUNTER_CELLS, (unsigned long long)bandRows * cols);
+}
+
+static void generationsTask(int band, int startRow, int endRow, void *arg){
+    GenerationsTask *task = arg;
+    generationsBand(task->state, task->map, task->newMap, task->rule, startRow, endRow,
+                    engineScratch(task->state, band), bandStats(task->state, band));
+}
+
+// Bit-plane kernel of the Generations rules, split in bands between the workers when threaded
+void updateMapGenerations(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule, int threaded){
+    if(threaded){
+        GenerationsTask task = {state, map, newMap, rule};
+        runWorkerPool(state->pool, generationsTask, map->rows, &task);
+    }
+    else{
+        generationsBand(state, map, newMap, rule, 0, map->rows, engineScratch(state, 0), bandStats(state, 0));
+    }
+}
@@ -0,0 +1,225 @@
+/*
+    Description:
+        Storage of a map of cells (see grid.h).
+
+    Sources:
+        https://en.wikipedia.org/wiki/Z-order_curve
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grid.h"
+#include "threads.h"
+
+// Read a layout name ("row", "tiled" or "morton"). Return 1 on success, 0 otherwise.
+int parseLayout(const char *text, GridLayout *layout){
+    if(strcmp(text, "row") == 0){
+        *layout = LAYOUT_ROW_MAJOR;
+    }
+    else if(strcmp(text, "tiled") == 0){
+        *layout = LAYOUT_TILED;
+    }
+    else if(strcmp(text, "morton") == 0){
+        *layout = LAYOUT_MORTON;
+    }
+    else{
+        return 0;
+    }
+    return 1;
+}
+
+// Read a topology name ("bounded" or "torus"). Return 1 on success, 0 otherwise.
+int parseTopology(const char *text, Topology *topology){
+    if(strcmp(text, "bounded") == 0){
+        *topology = TOPOLOGY_BOUNDED;
+    }
+    else if(strcmp(text, "torus") == 0){
+        *topology = TOPOLOGY_TORUS;
+    }
+    else{
+        return 0;
+    }
+    return 1;
+}
+
+// The cells live as long as the arena, they are given back with it. They are first touched by the workers of pool.
+void createGrid(Grid *grid, int rows, int cols, GridLayout layout, Arena *arena, WorkerPool *pool){
+    grid->rows = rows;
+    grid->cols = cols;
+    grid->layout = layout;
+    grid->topology = TOPOLOGY_BOUNDED;
+    grid->tilesPerRow = (cols + TILE_MASK) >> TILE_SHIFT;
+
+    if(layout == LAYOUT_ROW_MAJOR){
+        grid->size = (size_t)rows * cols;
+    }
+    else if(layout == LAYOUT_TILED){
+        grid->size = (size_t)((rows + TILE_MASK) >> TILE_SHIFT) * grid->tilesPerRow * TILE_AREA;
+    }
+    else{
+        // The Z-order curve covers a square with a power of two tiles per side
+        int tiles = (rows > cols ? rows : cols) + TILE_MASK;
+        tiles >>= TILE_SHIFT;
+        int side = 1;
+        while(side < tiles){
+            side <<= 1;
+        }
+        grid->size = (size_t)side * side * TILE_AREA;
+    }
+
+    grid->cells = arenaAlloc(arena, grid->size, CACHE_LINE);
+    clearGrid(grid, pool);
+}
+
+static void clearBand(int band, int startRow, int endRow, void *arg){
+    Grid *grid = arg;
+    (void)band;
+
+    // Bands start on a tile boundary: row-major and tiled bands are contiguous, the last one owns the padding
+    size_t start = cellIndex(grid, startRow, 0);
+    size_t end = endRow < grid->rows ? cellIndex(grid, endRow, 0) : grid->size;
+    memset(grid->cells + start, 0, end - start);
+}
+
+// Every band is cleared by the worker that computes it (first touch), the tiles of a Morton band are spread along the curve
+void clearGrid(Grid *grid, WorkerPool *pool){
+    if(pool->count > 1 && grid->layout != LAYOUT_MORTON){
+        runWorkerPool(pool, clearBand, grid->rows, grid);
+    }
+    else{
+        memset(grid->cells, 0, grid->size); // DEAD is 0
+    }
+}
+
+// Both grids must have the same dimensions
+void copyGrid(Grid *destination, const Grid *source){
+    if(destination->layout == source->layout){
+        memcpy(destination->cells, source->cells, source->size);
+        return;
+    }
+    for(int i = 0; i < source->rows; ++i){
+        for(int j = 0; j < source->cols; ++j){
+            setCell(destination, i, j, getCell(source, i, j));
+        }
+    }
+}
+
+void swapGrids(Grid *a, Grid *b){
+    Grid tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Packed grids ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+void createBitGrid(BitGrid *grid, int rows, int cols, Arena *arena){
+    grid->rows = rows;
+    grid->cols = cols;
+    grid->words = (cols + 63) / 64;
+    size_t size = (size_t)rows * grid->words * sizeof(unsigned long long);
+    grid->bits = arenaAlloc(arena, size, CACHE_LINE);
+    memset(grid->bits, 0, size);
+}
+
+typedef struct PackTask{
+    const Grid *grid;
+    BitGrid *bits;
+} PackTask;
+
+// Alive cells only, the dying cells of a Generations rule are 0
+static void packBand(int band, int startRow, int endRow, void *arg){
+    PackTask *task = arg;
+    (void)band;
+    for(int i = startRow; i < endRow; ++i){
+        unsigned long long *row = bitRow(task->bits, i);
+        for(int w = 0; w < task->bits->words; ++w){
+            unsigned long long word = 0;
+            int end = task->grid->cols - 64 * w < 64 ? task->grid->cols - 64 * w : 64;
+            for(int b = 0; b < end; ++b){
+                word |= (unsigned long long)(getCell(task->grid, i, 64 * w + b) == 1) << b;
+            }
+            row[w] = word;
+        }
+    }
+}
+
+static void unpackBand(int band, int startRow, int endRow, void *arg){
+    PackTask *task = arg;
+    (void)band;
+    for(int i = startRow; i < endRow; ++i){
+        const unsigned long long *row = bitRow(task->bits, i);
+        for(int j = 0; j < task->grid->cols; ++j){
+            setCell((Grid *)task->grid, i, j, (int)((row[j >> 6] >> (j & 63)) & 1));
+        }
+    }
+}
+
+// Both grids must have the same dimensions, every band is packed / unpacked by the worker that computes it
+void packGrid(const Grid *grid, BitGrid *bits, WorkerPool *pool){
+    PackTask task = {grid, bits};
+    runWorkerPool(pool, packBand, grid->rows, &task);
+}
+
+void unpackGrid(const BitGrid *bits, Grid *grid, WorkerPool *pool){
+    PackTask task = {grid, (BitGrid *)bits};
+    runWorkerPool(pool, unpackBand, grid->rows, &task);
+}
+
+// Alive cells are found a word at a time with their trailing zeros, an empty word costs one test
+void overlayGrid(const BitGrid *bits, Grid *grid){
+    for(int i = 0; i < bits->rows; ++i){
+        const unsigned long long *row = bitRow(bits, i);
+        for(int w = 0; w < bits->words; ++w){
+            for(unsigned long long word = row[w]; word != 0; word &= word - 1){
+                setCell(grid, i, 64 * w + __builtin_ctzll(word), 1);
+            }
+        }
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Tile counts ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Counts of a rows x cols map, every tile empty
+void createTileCounts(TileCounts *tiles, int rows, int cols, Arena *arena){
+    tiles->rows = (rows + TILE_MASK) >> TILE_SHIFT;
+    tiles->cols = (cols + TILE_MASK) >> TILE_SHIFT;
+    tiles->counts = arenaAlloc(arena, (size_t)tiles->rows * tiles->cols, CACHE_LINE);
+    memset(tiles->counts, 0, (size_t)tiles->rows * tiles->cols);
+}
+
+// Counts of a map that wasn't computed by a kernel (a level, a restored generation)
+void countTiles(const Grid *map, TileCounts *tiles){
+    emptyTiles(tiles, 0, map->rows);
+    for(int i = 0; i < map->rows; ++i){
+        for(int j = 0; j < map->cols; ++j){
+            *tileCount(tiles, i, j) += getCell(map, i, j) == 1;
+        }
+    }
+}
+
+// Alive cells of the rows x cols rectangle from (row, col), clipped to the map: one addition per tile inside the
+// rectangle, the cells of the tiles on its edges are read from the map
+unsigned long long tilePopulation(const TileCounts *tiles, const Grid *map, int row, int col, int rows, int cols){
+    int startRow = row > 0 ? row : 0, endRow = row + rows < map->rows ? row + rows : map->rows;
+    int startCol = col > 0 ? col : 0, endCol = col + cols < map->cols ? col + cols : map->cols;
+    unsigned long long population = 0;
+    for(int ti = startRow & ~TILE_MASK; ti < endRow; ti += TILE_SIZE){
+        int top = ti > startRow ? ti : startRow, bottom = ti + TILE_SIZE < endRow ? ti + TILE_SIZE : endRow;
+        for(int tj = startCol & ~TILE_MASK; tj < endCol; tj += TILE_SIZE){
+            int left = tj > startCol ? tj : startCol, right = tj + TILE_SIZE < endCol ? tj + TILE_SIZE : endCol;
+            int wholeRows = top == ti && (bottom == ti + TILE_SIZE || bottom == map->rows);
+            int wholeCols = left == tj && (right == tj + TILE_SIZE || right == map->cols);
+            if(wholeRows && wholeCols){
+                population += *tileCount(tiles, ti, tj);
+                continue;
+            }
+            for(int i = top; i < bottom; ++i){
+                for(int j = left; j < right; ++j){
+                    population += getCell(map, i, j) == 1;
+                }
+            }
+        }
+    }
+    return population;
+}
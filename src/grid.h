@@ -0,0 +1,147 @@
+/*
+    Description:
+        Storage of a map of cells. The cells are only reached through getCell() / setCell() so the engine, the
+        renderer and the level loader don't depend on the memory layout:
+            - LAYOUT_ROW_MAJOR: one row after the other, a neighbourhood spans three distant rows.
+            - LAYOUT_TILED:     TILE_SIZE x TILE_SIZE tiles stored contiguously, tiles row after row.
+            - LAYOUT_MORTON:    same tiles stored in Z-order, so neighbouring tiles are also close in memory.
+        A tile is 8x8 cells of one byte, a single 64-byte cache line.
+
+        The topology tells the kernels what lies beyond the edges: dead cells (TOPOLOGY_BOUNDED, the default) or
+        the opposite edge (TOPOLOGY_TORUS).
+
+        Cells are allocated from an arena (large grids land on huge pages, see arena.h) and are first touched
+        by the worker threads that will compute them: the helpers that go through every cell take the pool of
+        the simulation that owns the grid (programPool() in the programs, the pool of the handle in life.c).
+
+        A BitGrid is a packed map of alive cells, one bit per cell and rows of whole 64-bit words (bit j % 64 of
+        word j / 64 is column j, the bits after the last column are 0). Boards are generated and patterns
+        stamped a word at a time in a BitGrid, then unpacked into a Grid with unpackGrid() (every cell) or
+        overlayGrid() (only the alive ones, the other cells are kept).
+
+        TileCounts hold the alive cells of every TILE_SIZE x TILE_SIZE tile of a map, kept up to date by the
+        kernels (see trackTiles() in engine.h). tilePopulation() counts the alive cells of a rectangle from the
+        tiles it covers whole and only reads the cells of the tiles cut by its edges.
+*/
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+#include <string.h>
+#include "arena.h"
+#include "threads.h"
+
+#define TILE_SHIFT 3
+#define TILE_SIZE (1 << TILE_SHIFT)
+#define TILE_MASK (TILE_SIZE - 1)
+#define TILE_AREA (TILE_SIZE * TILE_SIZE)
+
+typedef enum GridLayout{
+    LAYOUT_ROW_MAJOR,
+    LAYOUT_TILED,
+    LAYOUT_MORTON
+} GridLayout;
+
+typedef enum Topology{
+    TOPOLOGY_BOUNDED,
+    TOPOLOGY_TORUS
+} Topology;
+
+typedef struct Grid{
+    int rows;
+    int cols;
+    GridLayout layout;
+    Topology topology;
+    int tilesPerRow;      // Number of tiles in a row of tiles (LAYOUT_TILED)
+    size_t size;          // Number of bytes of cells
+    unsigned char *cells;
+} Grid;
+
+typedef struct BitGrid{
+    int rows;
+    int cols;
+    int words;                // 64-bit words in a row
+    unsigned long long *bits;
+} BitGrid;
+
+typedef struct TileCounts{
+    int rows;              // Tiles in a column and a row, the last ones may be cut by the edges of the map
+    int cols;
+    unsigned char *counts; // Alive cells of every tile (0 to TILE_AREA), tile row after tile row
+} TileCounts;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int parseLayout(const char *text, GridLayout *layout);
+int parseTopology(const char *text, Topology *topology);
+void createGrid(Grid *grid, int rows, int cols, GridLayout layout, Arena *arena, WorkerPool *pool);
+void clearGrid(Grid *grid, WorkerPool *pool);
+void copyGrid(Grid *destination, const Grid *source);
+void swapGrids(Grid *a, Grid *b);
+void createBitGrid(BitGrid *grid, int rows, int cols, Arena *arena);
+void packGrid(const Grid *grid, BitGrid *bits, WorkerPool *pool);
+void unpackGrid(const BitGrid *bits, Grid *grid, WorkerPool *pool);
+void overlayGrid(const BitGrid *bits, Grid *grid);
+void createTileCounts(TileCounts *tiles, int rows, int cols, Arena *arena);
+void countTiles(const Grid *map, TileCounts *tiles);
+unsigned long long tilePopulation(const TileCounts *tiles, const Grid *map, int row, int col, int rows, int cols);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Accessors ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Spread the 16 low bits of x on the even bits
+static inline size_t spreadBits(unsigned x){
+    x = (x | (x << 8)) & 0x00FF00FFu;
+    x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    x = (x | (x << 1)) & 0x55555555u;
+    return x;
+}
+
+static inline size_t cellIndex(const Grid *grid, int i, int j){
+    if(grid->layout == LAYOUT_ROW_MAJOR){
+        return (size_t)i * grid->cols + j;
+    }
+
+    size_t tile;
+    if(grid->layout == LAYOUT_TILED){
+        tile = (size_t)(i >> TILE_SHIFT) * grid->tilesPerRow + (j >> TILE_SHIFT);
+    }
+    else{
+        tile = spreadBits((unsigned)i >> TILE_SHIFT) << 1 | spreadBits((unsigned)j >> TILE_SHIFT);
+    }
+    return tile * TILE_AREA + (size_t)((i & TILE_MASK) << TILE_SHIFT) + (j & TILE_MASK);
+}
+
+static inline int getCell(const Grid *grid, int i, int j){
+    return grid->cells[cellIndex(grid, i, j)];
+}
+
+static inline void setCell(Grid *grid, int i, int j, int state){
+    grid->cells[cellIndex(grid, i, j)] = (unsigned char)state;
+}
+
+static inline unsigned long long *bitRow(const BitGrid *grid, int i){
+    return grid->bits + (size_t)i * grid->words;
+}
+
+static inline int getBit(const BitGrid *grid, int i, int j){
+    return (int)((bitRow(grid, i)[j >> 6] >> (j & 63)) & 1);
+}
+
+static inline void setBit(BitGrid *grid, int i, int j, int alive){
+    unsigned long long *word = &bitRow(grid, i)[j >> 6];
+    *word = (*word & ~(1ull << (j & 63))) | (unsigned long long)(alive != 0) << (j & 63);
+}
+
+// Alive cells of the tile of cell (i, j)
+static inline unsigned char *tileCount(const TileCounts *tiles, int i, int j){
+    return tiles->counts + (size_t)(i >> TILE_SHIFT) * tiles->cols + (j >> TILE_SHIFT);
+}
+
+// Tiles of rows startRow to endRow - 1 emptied before a kernel counts them, startRow is on a tile boundary
+static inline void emptyTiles(TileCounts *tiles, int startRow, int endRow){
+    int start = startRow >> TILE_SHIFT, end = (endRow + TILE_MASK) >> TILE_SHIFT;
+    memset(tiles->counts + (size_t)start * tiles->cols, 0, (size_t)(end - start) * tiles->cols);
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+    Description:
+        Journal of the last generations (see history.h).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "history.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Encoding ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Longest encoding of a buffer of cells: a varint of each kind every 2 cells at worst
+static size_t encodedBound(size_t cells){
+    return 2 * cells + 32;
+}
+
+static size_t writeVarint(unsigned char *out, size_t value){
+    size_t length = 0;
+    while(value >= 0x80){
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+// Encode a XOR b (a alone when b is NULL), return the number of bytes written
+static size_t encodeCells(const unsigned char *a, const unsigned char *b, size_t cells, unsigned char *out){
+    size_t length = 0;
+    size_t k = 0;
+    while(k < cells){
+        size_t zeros = 0, literals = 0;
+        while(k + zeros < cells && (a[k + zeros] ^ (b != NULL ? b[k + zeros] : 0)) == 0){
+            zeros++;
+        }
+        k += zeros;
+        while(k + literals < cells && (a[k + literals] ^ (b != NULL ? b[k + literals] : 0)) != 0){
+            literals++;
+        }
+        if(literals == 0){
+            break; // Only zeros left, they are implicit
+        }
+        length += writeVarint(out + length, zeros);
+        length += writeVarint(out + length, literals);
+        for(size_t l = 0; l < literals; ++l, ++k){
+            out[length++] = a[k] ^ (b != NULL ? b[k] : 0);
+        }
+    }
+    return length;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Ring ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static inline unsigned char ringByte(const History *history, size_t offset){
+    return history->ring[offset % history->capacity];
+}
+
+static size_t readVarint(const History *history, size_t *offset){
+    size_t value = 0;
+    int shift = 0;
+    unsigned char byte;
+    do{
+        byte = ringByte(history, (*offset)++);
+        value |= (size_t)(byte & 0x7F) << shift;
+        shift += 7;
+    } while(byte & 0x80);
+    return value;
+}
+
+// XOR the cells encoded at offset in the ring into cells
+static void applyEncoded(const History *history, size_t offset, unsigned size, unsigned char *cells){
+    size_t end = offset + size;
+    size_t k = 0;
+    while(offset < end){
+        k += readVarint(history, &offset);
+        size_t literals = readVarint(history, &offset);
+        for(size_t l = 0; l < literals; ++l){
+            cells[k++] ^= ringByte(history, offset++);
+        }
+    }
+}
+
+// Append bytes at the end of the ring, return their offset
+static size_t ringAppend(History *history, const unsigned char *bytes, size_t size){
+    size_t offset = (history->start + history->used) % history->capacity;
+    size_t first = size < history->capacity - offset ? size : history->capacity - offset;
+    memcpy(history->ring + offset, bytes, first);
+    memcpy(history->ring, bytes + first, size - first);
+    history->used += size;
+    return offset;
+}
+
+static HistoryEntry *entryAt(const History *history, int index){
+    return &history->entries[(history->firstEntry + index) % history->entryCapacity];
+}
+
+// Forget the oldest keyframe and the deltas that depend on it
+static void evictOldest(History *history){
+    do{
+        HistoryEntry *entry = entryAt(history, 0);
+        size_t size = (size_t)entry->deltaSize + entry->keyframeSize;
+        history->start = (history->start + size) % history->capacity;
+        history->used -= size;
+        history->firstEntry = (history->firstEntry + 1) % history->entryCapacity;
+        history->entryCount--;
+    } while(history->entryCount > 0 && entryAt(history, 0)->keyframeSize == 0);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Journal ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// The budget holds the entries and the encoded generations, the buffers of a generation come on top of it
+void initHistory(History *history, int rows, int cols, size_t budget, Arena *arena){
+    history->cells = (size_t)rows * cols;
+    history->entryCapacity = (int)(budget / 256 > 16 ? budget / 256 : 16);
+    size_t entriesSize = (size_t)history->entryCapacity * sizeof(HistoryEntry);
+    if(budget <= entriesSize){
+        printf("\nERROR: initHistory() function => a budget of %zu bytes is too small\n", budget);
+        exit(1);
+    }
+    history->capacity = budget - entriesSize;
+    history->entries = arenaAlloc(arena, entriesSize, CACHE_LINE);
+    history->ring = arenaAlloc(arena, history->capacity, CACHE_LINE);
+    history->newest = arenaAlloc(arena, history->cells, CACHE_LINE);
+    history->work = arenaAlloc(arena, history->cells, CACHE_LINE);
+    history->encoded = arenaAlloc(arena, 2 * encodedBound(history->cells), CACHE_LINE);
+    clearHistory(history);
+}
+
+void clearHistory(History *history){
+    history->start = 0;
+    history->used = 0;
+    history->firstEntry = 0;
+    history->entryCount = 0;
+}
+
+long long oldestGeneration(const History *history){
+    return history->entryCount > 0 ? entryAt(history, 0)->generation : -1;
+}
+
+long long newestGeneration(const History *history){
+    return history->entryCount > 0 ? entryAt(history, history->entryCount - 1)->generation : -1;
+}
+
+// Bytes of encoded generations
+size_t historyBytes(const History *history){
+    return history->used;
+}
+
+// Record map as the given generation. Unless it follows the newest generation the journal starts again from it.
+void recordGeneration(History *history, const Grid *map, long long generation){
+    for(int i = 0; i < map->rows; ++i){
+        for(int j = 0; j < map->cols; ++j){
+            history->work[(size_t)i * map->cols + j] = getCell(map, i, j);
+        }
+    }
+    if(history->entryCount > 0 && generation != newestGeneration(history) + 1){
+        clearHistory(history);
+    }
+
+    HistoryEntry entry = {generation, 0, 0, 0, 0};
+    unsigned char *keyframe = history->encoded + encodedBound(history->cells);
+    if(history->entryCount > 0){
+        entry.deltaSize = (unsigned)encodeCells(history->work, history->newest, history->cells, history->encoded);
+    }
+    int needKeyframe = history->entryCount == 0 || generation % HISTORY_KEYFRAME == 0;
+    while(1){
+        if(needKeyframe && entry.keyframeSize == 0){
+            entry.keyframeSize = (unsigned)encodeCells(history->work, NULL, history->cells, keyframe);
+            if(entry.keyframeSize == 0){
+                entry.keyframeSize = (unsigned)writeVarint(keyframe, 0); // An empty map still needs a keyframe:
+                entry.keyframeSize += (unsigned)writeVarint(keyframe + 1, 0); // no zeros, no literals
+            }
+        }
+        size_t size = (size_t)entry.deltaSize + entry.keyframeSize;
+        if(size > history->capacity){
+            clearHistory(history); // A single generation doesn't fit in the budget
+            memcpy(history->newest, history->work, history->cells);
+            return;
+        }
+        if(history->used + size <= history->capacity && history->entryCount < history->entryCapacity){
+            break;
+        }
+        evictOldest(history);
+        if(history->entryCount == 0){
+            needKeyframe = 1; // The entry becomes the oldest one, its delta is useless
+            entry.deltaSize = 0;
+        }
+    }
+
+    entry.delta = ringAppend(history, history->encoded, entry.deltaSize);
+    entry.keyframe = ringAppend(history, keyframe, entry.keyframeSize);
+    *entryAt(history, history->entryCount) = entry;
+    history->entryCount++;
+    memcpy(history->newest, history->work, history->cells);
+}
+
+// Write generation into map, which holds generation current. Return 0 if generation isn't in the journal.
+int restoreGeneration(History *history, Grid *map, long long current, long long generation){
+    long long oldest = oldestGeneration(history);
+    if(history->entryCount == 0 || generation < oldest || generation > newestGeneration(history)){
+        return 0;
+    }
+
+    int target = (int)(generation - oldest);
+    int keyframe = target;
+    while(entryAt(history, keyframe)->keyframeSize == 0){
+        keyframe--; // The oldest entry always has one
+    }
+
+    // Start from the map itself when it is closer than the keyframe
+    long long distance = current > generation ? current - generation : generation - current;
+    if(current >= oldest && current <= newestGeneration(history) && distance <= target - keyframe){
+        for(int i = 0; i < map->rows; ++i){
+            for(int j = 0; j < map->cols; ++j){
+                history->work[(size_t)i * map->cols + j] = getCell(map, i, j);
+            }
+        }
+        // Delta k goes from generation k - 1 to k and back
+        int from = (int)(current - oldest);
+        for(int k = from; k > target; --k){
+            HistoryEntry *entry = entryAt(history, k);
+            applyEncoded(history, entry->delta, entry->deltaSize, history->work);
+        }
+        for(int k = from + 1; k <= target; ++k){
+            HistoryEntry *entry = entryAt(history, k);
+            applyEncoded(history, entry->delta, entry->deltaSize, history->work);
+        }
+    }
+    else{
+        HistoryEntry *entry = entryAt(history, keyframe);
+        memset(history->work, 0, history->cells);
+        applyEncoded(history, entry->keyframe, entry->keyframeSize, history->work);
+        for(int k = keyframe + 1; k <= target; ++k){
+            entry = entryAt(history, k);
+            applyEncoded(history, entry->delta, entry->deltaSize, history->work);
+        }
+    }
+
+    for(int i = 0; i < map->rows; ++i){
+        for(int j = 0; j < map->cols; ++j){
+            setCell(map, i, j, history->work[(size_t)i * map->cols + j]);
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,54 @@
+/*
+    Description:
+        Journal of the last generations, to rewind and replay them without computing them again. Every
+        generation is stored as its difference with the previous one: the cells XOR-ed together, most of them
+        0, run-length encoded. Every HISTORY_KEYFRAME generations a full copy, encoded the same way, is stored
+        too, so that a far generation is rebuilt from its keyframe and a few deltas instead of all of them.
+        The journal never uses more than its memory budget: the oldest keyframe and its deltas are forgotten
+        first, so the oldest generation kept always has a keyframe.
+
+        Encoding of a buffer of cells: pairs of varints (number of zero bytes, number of literal bytes) followed
+        by the literal bytes.
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include "grid.h"
+
+#define HISTORY_KEYFRAME 32
+#define HISTORY_BUDGET (16u << 20) // Default budget in bytes
+
+typedef struct HistoryEntry{
+    long long generation;
+    size_t delta;       // Offset of the delta with the previous generation in the ring
+    size_t keyframe;    // Offset of the keyframe in the ring
+    unsigned deltaSize; // 0 when the previous generation isn't known
+    unsigned keyframeSize; // 0 without keyframe
+} HistoryEntry;
+
+typedef struct History{
+    size_t cells;             // Cells of a generation, rows * cols
+    unsigned char *ring;      // Encoded deltas and keyframes, oldest first
+    size_t capacity;
+    size_t start;             // Offset of the oldest byte
+    size_t used;
+    HistoryEntry *entries;    // Ring of entries, oldest first
+    int entryCapacity;
+    int firstEntry;
+    int entryCount;
+    unsigned char *newest;    // Cells of the newest generation, row after row
+    unsigned char *work;      // Cells being recorded or rebuilt
+    unsigned char *encoded;   // Delta and keyframe being recorded
+} History;
+
+void initHistory(History *history, int rows, int cols, size_t budget, Arena *arena);
+void clearHistory(History *history);
+void recordGeneration(History *history, const Grid *map, long long generation);
+int restoreGeneration(History *history, Grid *map, long long current, long long generation);
+long long oldestGeneration(const History *history);
+long long newestGeneration(const History *history);
+size_t historyBytes(const History *history);
+
+#endif
@@ -0,0 +1,158 @@
+/*
+    Description:
+        Keyboard commands of the interactive program (see input.h).
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef NO_CURSES
+#include <curses.h>
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include "input.h"
+#include "render.h"
+
+#define KEY_NONE -1
+#define KEY_CLOSED -2 // stdin is closed
+#define KEY_DELETE 127
+
+static int prompt = 0; // Row of the jump prompt
+static int ended = 0;  // stdin reached its end, every later read is KEY_CLOSED
+
+void initInput(int promptRow){
+    prompt = promptRow;
+#ifndef NO_CURSES
+    if(rendererBackend() == BACKEND_CURSES){
+        noecho();
+        cbreak();
+    }
+#endif
+}
+
+// Next key pressed within timeoutMs, KEY_NONE if none, KEY_CLOSED once stdin is closed (the ANSI and null backends
+// read stdin)
+static int readKey(int timeoutMs){
+#ifndef NO_CURSES
+    if(rendererBackend() == BACKEND_CURSES){
+        timeout(timeoutMs);
+        int ch = getch();
+        return ch == ERR ? KEY_NONE : ch;
+    }
+#endif
+#ifndef _WIN32
+    if(ended){
+        return KEY_CLOSED;
+    }
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    unsigned char ch;
+    if(poll(&input, 1, timeoutMs) <= 0){
+        return KEY_NONE;
+    }
+    ssize_t size = read(STDIN_FILENO, &ch, 1);
+    if(size == 1){
+        return ch;
+    }
+    if(size == 0 || errno != EINTR){
+        ended = 1; // A closed stdin is always readable, polling it again would spin
+        return KEY_CLOSED;
+    }
+    return KEY_NONE;
+#else
+    return KEY_NONE;
+#endif
+}
+
+// Read the line typed on the prompt row, 0 if nothing could be read
+static int readText(const char *question, char *text, int size){
+    clearLine(prompt, 1);
+    drawText(prompt, 1, "%s: ", question);
+#ifndef NO_CURSES
+    if(rendererBackend() == BACKEND_CURSES){
+        timeout(WAIT_FOREVER);
+        echo();
+        int status = getnstr(text, size - 1);
+        noecho();
+        return status != ERR;
+    }
+#endif
+
+    // Echo the keys ourselves, the terminal is raw (ANSI) or not a terminal (null)
+    int col = 1 + (int)strlen(question) + 2;
+    int length = 0;
+    presentFrame();
+    for(;;){
+        int ch = readKey(WAIT_FOREVER);
+        if(ch == KEY_NONE || ch == KEY_CLOSED){
+            return 0;
+        }
+        if(ch == '\n' || ch == '\r'){
+            break;
+        }
+        if((ch == KEY_DELETE || ch == '\b') && length > 0){
+            --length;
+            drawText(prompt, col + length, " ");
+        }
+        else if(ch >= ' ' && ch < KEY_DELETE && length < size - 1){
+            text[length] = (char)ch;
+            drawText(prompt, col + length, "%c", ch);
+            ++length;
+        }
+        presentFrame();
+    }
+    text[length] = '\0';
+    return 1;
+}
+
+// Read the number typed after 'n' or 'g', -1 if nothing valid was typed
+static long long readNumber(const char *question){
+    char text[COMMAND_TEXT_SIZE];
+    if(!readText(question, text, sizeof(text))){
+        return -1;
+    }
+
+    char *end;
+    long long number = strtoll(text, &end, 10);
+    return end != text && *end == '\0' && number >= 0 ? number : -1;
+}
+
+Command waitCommand(int timeoutMs){
+    Command command = {COMMAND_NONE, 0, ""};
+    int ch = readKey(timeoutMs);
+
+    if(ch == 'p'){
+        command.type = COMMAND_PAUSE;
+    }
+    else if(ch == 's'){
+        command.type = COMMAND_STEP;
+    }
+    else if(ch == 'b'){
+        command.type = COMMAND_BACK;
+    }
+    else if(ch == '+'){
+        command.type = COMMAND_FASTER;
+    }
+    else if(ch == '-'){
+        command.type = COMMAND_SLOWER;
+    }
+    else if(ch == 'q' || ch == KEY_CLOSED){
+        command.type = COMMAND_QUIT;
+    }
+    else if(ch == 'n'){
+        command.value = readNumber("Generations to advance");
+        command.type = command.value >= 0 ? COMMAND_ADVANCE : COMMAND_NONE;
+    }
+    else if(ch == 'g'){
+        command.value = readNumber("Jump to generation");
+        command.type = command.value >= 0 ? COMMAND_JUMP : COMMAND_NONE;
+    }
+    else if(ch == 'i'){
+        int valid = readText("Pattern name,row,col", command.text, sizeof(command.text));
+        command.type = valid && command.text[0] != '\0' ? COMMAND_PLACE : COMMAND_NONE;
+    }
+    return command;
+}
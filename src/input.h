@@ -0,0 +1,42 @@
+/*
+    Description:
+        Keyboard commands of the interactive program. waitCommand() blocks in getch() (curses renderer) or in
+        poll() on stdin (other renderers, see render.h) until a key is pressed or the timeout is over, so the
+        wait between two frames is also the time the program listens to the keyboard, and a paused program
+        sleeps in the kernel instead of polling:
+            - 'p': pause / resume          - 's': step one generation (pauses)
+            - '+' / '-': faster / slower   - 'n': advance the number of generations typed on the prompt line
+            - 'q': quit                    - 'g': jump to the generation typed on the prompt line
+            - 'b': back one generation (pauses) - 'i': insert the pattern typed on the prompt line (see pattern.h)
+        The end of stdin (a pipe or a file given to the ANSI or null renderer) quits like 'q'.
+*/
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#define WAIT_FOREVER -1
+#define COMMAND_TEXT_SIZE 48
+
+typedef enum CommandType{
+    COMMAND_NONE, // Timeout, or a key without a command
+    COMMAND_PAUSE,
+    COMMAND_STEP,
+    COMMAND_BACK,
+    COMMAND_FASTER,
+    COMMAND_SLOWER,
+    COMMAND_ADVANCE,
+    COMMAND_JUMP,
+    COMMAND_PLACE,
+    COMMAND_QUIT
+} CommandType;
+
+typedef struct Command{
+    CommandType type;
+    long long value; // Generations of COMMAND_ADVANCE, target generation of COMMAND_JUMP
+    char text[COMMAND_TEXT_SIZE]; // Placement of COMMAND_PLACE
+} Command;
+
+void initInput(int promptRow);
+Command waitCommand(int timeoutMs);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    Description:
+        Jumps of many generations computed in the background (see jump.h).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "jump.h"
+
+static void *jumpLoop(void *arg){
+    Jump *jump = arg;
+    Publisher *publisher = jump->publisher;
+    Frame *first = takeFrame(publisher);
+    copyGrid(&first->map, jump->map);
+    countTiles(&first->map, &first->tiles);
+    first->generation = jump->generation;
+    publishFrame(publisher, first);
+
+    for(long long g = 0; g < jump->generations && !atomic_load(&jump->cancelled); ++g){
+        const Frame *from = publishedFrame(publisher);
+        Frame *to = takeFrame(publisher);
+        trackTiles(jump->state, &to->tiles);
+        stepMap(jump->state, JUMP_ENGINE, &from->map, &to->map, jump->rule);
+        to->generation = from->generation + 1;
+        publishFrame(publisher, to);
+        if(jump->series != NULL){
+            StepStats stats;
+            stepStats(jump->state, &stats);
+            addRecord(jump->series, to->generation, &stats);
+        }
+        if(jump->exporter != NULL){
+            exportFrame(jump->exporter, &to->map, to->generation);
+        }
+        atomic_store(&jump->done, g + 1);
+    }
+    trackTiles(jump->state, NULL);
+    copyGrid(jump->map, &publishedFrame(publisher)->map);
+    return NULL;
+}
+
+// The engine tables of JUMP_ENGINE must be built (initEngine()) before
+void startJump(Jump *jump, EngineState *state, Grid *map, Publisher *publisher, const Rule *rule,
+               long long generations, Series *series, Exporter *exporter, long long generation){
+    jump->state = state;
+    jump->map = map;
+    jump->publisher = publisher;
+    jump->rule = rule;
+    jump->generations = generations;
+    jump->series = series;
+    jump->exporter = exporter;
+    jump->generation = generation;
+    atomic_init(&jump->done, 0);
+    atomic_init(&jump->cancelled, 0);
+    if(pthread_create(&jump->thread, NULL, jumpLoop, jump) != 0){
+        printf("\nERROR: startJump() function => pthread_create failed\n");
+        exit(1);
+    }
+    jump->running = 1;
+}
+
+// Return 1 once the jump is over (finished or cancelled), the map can then be used again
+int jumpDone(Jump *jump){
+    if(!jump->running){
+        return 1;
+    }
+    if(atomic_load(&jump->done) < jump->generations && !atomic_load(&jump->cancelled)){
+        return 0;
+    }
+    pthread_join(jump->thread, NULL);
+    jump->running = 0;
+    return 1;
+}
+
+// Stop after the generation being computed, jumpProgress() then tells where the map is
+void cancelJump(Jump *jump){
+    atomic_store(&jump->cancelled, 1);
+    if(jump->running){
+        pthread_join(jump->thread, NULL);
+        jump->running = 0;
+    }
+}
+
+long long jumpProgress(const Jump *jump){
+    return atomic_load(&jump->done);
+}
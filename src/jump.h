@@ -0,0 +1,45 @@
+/*
+    Description:
+        Jumps of many generations computed in the background. The interactive loop hands the map to a jump
+        thread that steps it with the multithreaded engine, fastest of the engines for every rule, and keeps
+        drawing until jumpDone() says the map is back. Every generation is computed in a frame of the publisher
+        and published (see publish.h), so the interactive loop draws the latest one while the next is computed,
+        without the jump ever waiting for it. The map and the engine state must not be used by anyone else until
+        the jump is done. The statistics of every generation computed go to the series and the generations to
+        the exporter, if any.
+*/
+
+#ifndef JUMP_H
+#define JUMP_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "engine.h"
+#include "export.h"
+#include "publish.h"
+#include "series.h"
+
+#define JUMP_ENGINE ENGINE_THREADED
+
+typedef struct Jump{
+    EngineState *state;
+    Grid *map;              // Written back with the last generation when the jump is over
+    Publisher *publisher;   // Frames of the map's dimensions, layout and topology
+    const Rule *rule;
+    long long generations;  // Generations to compute
+    Series *series;         // NULL without statistics
+    Exporter *exporter;     // NULL without images
+    long long generation;   // Generation of the map when the jump started
+    atomic_llong done;      // Generations computed so far
+    atomic_int cancelled;
+    int running;
+    pthread_t thread;
+} Jump;
+
+void startJump(Jump *jump, EngineState *state, Grid *map, Publisher *publisher, const Rule *rule,
+               long long generations, Series *series, Exporter *exporter, long long generation);
+int jumpDone(Jump *jump);
+void cancelJump(Jump *jump);
+long long jumpProgress(const Jump *jump);
+
+#endif
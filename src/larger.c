@@ -0,0 +1,208 @@
+/*
+    Description:
+        Kernel of the Larger-than-Life rules (see engine.h). Counting the (2r + 1)^2 cells of every neighbourhood
+        would cost O(r^2) per cell, so the alive cells of the band and of its halo are first summed in tables
+        and every count is then read in O(1) whatever the radius:
+            - Moore neighbourhood: a summed-area table, the square is 4 reads.
+            - von Neumann neighbourhood: prefix sums along both diagonals. The diamond of the first cell of a
+              row is summed row by row, then it slides one column at a time: its two right edges are diagonal
+              segments that come in, its two left edges diagonal segments that go out, 2 reads each.
+
+    Sources:
+        https://conwaylife.com/wiki/Larger_than_Life
+        https://en.wikipedia.org/wiki/Summed-area_table
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "engine.h"
+#include "perf.h"
+#include "prof.h"
+#include "threads.h"
+
+typedef struct LargerTask{
+    EngineState *state;
+    const Grid *map;
+    Grid *newMap;
+    const Rule *rule;
+} LargerTask;
+
+// Tables of a band, padded cell (y, x) is map cell (startRow - radius + y, x - radius). Every table has one more
+// row above and one more column on both sides, so the prefix sums never read out of it.
+// The sums are unsigned and wrap around on boards of more than 2^32 cells: a count is a difference of sums
+// computed modulo 2^32, exact since it is at most (2r + 1)^2.
+typedef struct Sums{
+    int width;               // Columns of a table row, padded columns + 2
+    unsigned *area;          // Sum of the padded cells (y', x') with y' <= y and x' <= x
+    unsigned *diagonal;      // Sum of the padded cells (y - k, x - k)
+    unsigned *antiDiagonal;  // Sum of the padded cells (y - k, x + k)
+} Sums;
+
+static inline unsigned sumAt(const Sums *sums, const unsigned *table, int y, int x){
+    return table[(size_t)(y + 1) * sums->width + x + 1];
+}
+
+// Alive cells of the rectangle [y1, y2] x [x1, x2]
+static inline int sumRectangle(const Sums *sums, int y1, int x1, int y2, int x2){
+    return (int)(sumAt(sums, sums->area, y2, x2) - sumAt(sums, sums->area, y1 - 1, x2)
+               - sumAt(sums, sums->area, y2, x1 - 1) + sumAt(sums, sums->area, y1 - 1, x1 - 1));
+}
+
+// Alive cells of the diagonal segment from (y1, x1) down to (y2, x1 + y2 - y1), 0 when y2 < y1
+static inline int sumDiagonal(const Sums *sums, int y1, int x1, int y2){
+    if(y2 < y1){
+        return 0;
+    }
+    return (int)(sumAt(sums, sums->diagonal, y2, x1 + y2 - y1) - sumAt(sums, sums->diagonal, y1 - 1, x1 - 1));
+}
+
+// Alive cells of the anti-diagonal segment from (y1, x1) down to (y2, x1 - (y2 - y1)), 0 when y2 < y1
+static inline int sumAntiDiagonal(const Sums *sums, int y1, int x1, int y2){
+    if(y2 < y1){
+        return 0;
+    }
+    return (int)(sumAt(sums, sums->antiDiagonal, y2, x1 - (y2 - y1)) - sumAt(sums, sums->antiDiagonal, y1 - 1, x1 + 1));
+}
+
+// Fill the tables of rows [startRow - radius, endRow + radius) of the map, the halo is dead or wraps around
+static void buildSums(const Grid *map, const Rule *rule, int startRow, int endRow, Sums *sums, Arena *scratch){
+    int radius = rule->radius;
+    int height = endRow - startRow + 2 * radius;
+    int padded = map->cols + 2 * radius;
+    int torus = map->topology == TOPOLOGY_TORUS;
+    int diamond = rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN;
+    size_t size = (size_t)(height + 1) * (padded + 2) * sizeof(unsigned);
+
+    sums->width = padded + 2;
+    sums->diagonal = sums->antiDiagonal = NULL;
+    sums->area = arenaAlloc(scratch, size, CACHE_LINE);
+    memset(sums->area, 0, size);
+    if(diamond){
+        sums->diagonal = arenaAlloc(scratch, size, CACHE_LINE);
+        sums->antiDiagonal = arenaAlloc(scratch, size, CACHE_LINE);
+        memset(sums->diagonal, 0, size);
+        memset(sums->antiDiagonal, 0, size);
+    }
+
+    for(int y = 0; y < height; ++y){
+        int i = startRow - radius + y;
+        int inside = 1;
+        if(torus){
+            i = ((i % map->rows) + map->rows) % map->rows;
+        }
+        else if(i < 0 || i >= map->rows){
+            inside = 0; // Dead padding
+        }
+
+        unsigned *area = sums->area + (size_t)(y + 1) * sums->width + 1;
+        unsigned rowSum = 0;
+        for(int x = 0; x < padded; ++x){
+            int j = x - radius;
+            unsigned cell = 0;
+            if(torus){
+                j = ((j % map->cols) + map->cols) % map->cols;
+                cell = getCell(map, i, j) == ALIVE;
+            }
+            else if(inside && j >= 0 && j < map->cols){
+                cell = getCell(map, i, j) == ALIVE;
+            }
+
+            rowSum += cell;
+            area[x] = area[x - sums->width] + rowSum;
+            if(diamond){
+                size_t at = (size_t)(y + 1) * sums->width + x + 1;
+                sums->diagonal[at] = cell + sums->diagonal[at - sums->width - 1];
+                sums->antiDiagonal[at] = cell + sums->antiDiagonal[at - sums->width + 1];
+            }
+        }
+    }
+}
+
+// Compute rows [startRow, endRow) of newMap
+static void largerBand(const EngineState *state, const Grid *map, Grid *newMap, const Rule *rule, int startRow,
+                       int endRow, Arena *scratch, StepStats *stats){
+    int radius = rule->radius;
+    int cols = map->cols;
+    unsigned long long births = 0, deaths = 0;
+    StepStats counted; // Written to stats once, the bands' statistics share cache lines
+    emptyStats(&counted, map);
+    int track = state->trackingBounds;
+    TileCounts *tiles = state->tiles;
+    Sums sums;
+
+    perfStart(PERF_PACK);
+    resetArena(scratch); // Temporary data of the previous generation
+    buildSums(map, rule, startRow, endRow, &sums, scratch);
+    if(tiles != NULL){
+        emptyTiles(tiles, startRow, endRow);
+    }
+    perfStop(PERF_PACK);
+
+    perfStart(PERF_COMPUTE);
+    for(int i = startRow; i < endRow; ++i){
+        int y = i - startRow + radius; // Padded coordinates of the cell
+        int count = 0;
+
+        if(rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN){
+            for(int dy = -radius; dy <= radius; ++dy){ // Diamond of column 0, centred on padded column radius
+                int width = radius - abs(dy);
+                count += sumRectangle(&sums, y + dy, radius - width, y + dy, radius + width);
+            }
+        }
+
+        for(int j = 0; j < cols; ++j){
+            int x = j + radius;
+            if(rule->neighbourhood == NEIGHBOURHOOD_VON_NEUMANN){
+                if(j > 0){
+                    // The diamond moved from x - 1 to x
+                    count += sumDiagonal(&sums, y - radius, x, y) + sumAntiDiagonal(&sums, y + 1, x + radius - 1, y + radius);
+                    count -= sumAntiDiagonal(&sums, y - radius, x - 1, y) + sumDiagonal(&sums, y + 1, x - radius, y + radius);
+                }
+            }
+            else{
+                count = sumRectangle(&sums, y - radius, x - radius, y + radius, x + radius);
+            }
+
+            int state = getCell(map, i, j);
+            int self = state == ALIVE && !rule->middle; // The tables count the cell itself
+            int newState = nextState(rule, state, count - self);
+            setCell(newMap, i, j, newState);
+            births += state == DEAD && newState == ALIVE;
+            deaths += state == ALIVE && newState != ALIVE;
+            if(newState == ALIVE){
+                counted.population++;
+                if(track){
+                    addBounds(&counted, i, i, j, j);
+                }
+                if(tiles != NULL){
+                    ++*tileCount(tiles, i, j);
+                }
+            }
+        }
+    }
+    perfStop(PERF_COMPUTE);
+    counted.births = births;
+    counted.deaths = deaths;
+    *stats = counted;
+
+    PROF_COUNT(COUNTER_BIRTHS, births);
+    PROF_COUNT(COUNTER_DEATHS, deaths);
+    PROF_COUNT(COUNTER_CELLS, (unsigned long long)(endRow - startRow) * cols);
+}
+
+static void largerTask(int band, int startRow, int endRow, void *arg){
+    LargerTask *task = arg;
+    largerBand(task->state, task->map, task->newMap, task->rule, startRow, endRow, engineScratch(task->state, band),
+               bandStats(task->state, band));
+}
+
+// Larger-than-Life kernel, split in bands between the workers when threaded
+void updateMapLarger(EngineState *state, const Grid *map, Grid *newMap, const Rule *rule, int threaded){
+    if(threaded){
+        LargerTask task = {state, map, newMap, rule};
+        runWorkerPool(state->pool, largerTask, map->rows, &task);
+    }
+    else{
+        largerBand(state, map, newMap, rule, 0, map->rows, engineScratch(state, 0), bandStats(state, 0));
+    }
+}
@@ -0,0 +1,255 @@
+/*
+    Description:
+        Simulations of the game of life for programs without a terminal (see life.h).
+
+        The generations are frames of a publisher (see publish.h): a step writes the next generation in a frame
+        no reader can reach and publishes it, a snapshot is a reader of the publisher. The cells set by
+        lifeSetCell() go to a draft, a copy of the published frame taken by the simulation and published later.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "engine.h"
+#include "life.h"
+#include "pattern.h"
+#include "publish.h"
+
+#define LIFE_ENGINE ENGINE_THREADED // Fastest kernel of every rule, runs in the caller with a single thread
+
+struct Life{
+    EngineState engine;
+    WorkerPool pool;
+    Arena arena; // Patterns while they are loaded
+    Rule rule;
+    int rows;
+    int cols;
+    Publisher publisher;
+    Frame *draft; // Published generation with the cells set since, NULL without edits
+};
+
+// A LifeSnapshot is a Reader of the publisher, the type is only declared
+static Reader *snapshotReader(const LifeSnapshot *snapshot){
+    return (Reader *)snapshot;
+}
+
+static const Frame *snapshotFrame(const LifeSnapshot *snapshot){
+    return readerFrame(snapshotReader(snapshot));
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Frames ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// The draft, copied from the published frame the first time
+static Frame *draftFrame(Life *life){
+    if(life->draft == NULL){
+        const Frame *published = publishedFrame(&life->publisher);
+        Frame *frame = takeFrame(&life->publisher);
+        copyGrid(&frame->map, &published->map);
+        memcpy(frame->tiles.counts, published->tiles.counts, (size_t)frame->tiles.rows * frame->tiles.cols);
+        frame->generation = published->generation;
+        life->draft = frame;
+    }
+    return life->draft;
+}
+
+// A frame to replace the whole board with, the draft if there is one
+static Frame *boardFrame(Life *life){
+    return life->draft != NULL ? life->draft : takeFrame(&life->publisher);
+}
+
+static void publish(Life *life, Frame *frame){
+    publishFrame(&life->publisher, frame);
+    life->draft = NULL;
+}
+
+static void publishDraft(Life *life){
+    if(life->draft != NULL){
+        publish(life, life->draft);
+    }
+}
+
+// The generation the simulation is at: the draft if cells were set, the published frame otherwise
+static const Frame *head(const Life *life){
+    return life->draft != NULL ? life->draft : publishedFrame(&life->publisher);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Simulation ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// A dead board of rows x cols cells, NULL if the size or the rule is invalid (or the handle can't be allocated).
+// The buffers, the engine and the worker pool exit(1) when they run out of memory or threads.
+Life *lifeCreate(int rows, int cols, const char *rule, int threads){
+    if(rows <= 0 || cols <= 0){
+        return NULL;
+    }
+    Life *life = malloc(sizeof(Life));
+    if(life == NULL){
+        return NULL;
+    }
+    if(!parseRule(rule, &life->rule)){
+        free(life);
+        return NULL;
+    }
+
+    initWorkerPool(&life->pool);
+    startWorkerPool(&life->pool, threads);
+    initEngineState(&life->engine, &life->pool);
+    initEngine(&life->engine, LIFE_ENGINE, &life->rule);
+    initArena(&life->arena, "life", 0);
+    life->rows = rows;
+    life->cols = cols;
+    initPublisher(&life->publisher, rows, cols, LAYOUT_ROW_MAJOR, TOPOLOGY_BOUNDED, &life->pool);
+    life->draft = NULL;
+    lifeClear(life);
+    return life;
+}
+
+// Every snapshot of the simulation must have been freed
+void lifeDestroy(Life *life){
+    if(life == NULL){
+        return;
+    }
+    freeWorkerPool(&life->pool);
+    freeEngineState(&life->engine);
+    freeArena(&life->arena);
+    freePublisher(&life->publisher);
+    free(life);
+}
+
+// Replace the board with the pattern of a .rle or .lvl file, its top left corner on (row, col). Return 1 on
+// success, 0 if the file can't be read (the board is then unchanged).
+int lifeLoad(Life *life, const char *path, int row, int col){
+    ArenaMark mark = arenaMark(&life->arena);
+    Pattern pattern;
+    if(!readPattern(path, &pattern, &life->arena)){
+        arenaRelease(&life->arena, mark);
+        return 0;
+    }
+    lifeClear(life);
+    for(int i = 0; i < pattern.rows; ++i){
+        for(int j = 0; j < pattern.cols; ++j){
+            if(pattern.cells[i * pattern.cols + j]){
+                lifeSetCell(life, row + i, col + j, ALIVE);
+            }
+        }
+    }
+    publishDraft(life);
+    arenaRelease(&life->arena, mark);
+    return 1;
+}
+
+// Every cell dead, back to generation 0
+void lifeClear(Life *life){
+    Frame *frame = boardFrame(life);
+    memset(frame->map.cells, 0, frame->map.size);
+    memset(frame->tiles.counts, 0, (size_t)frame->tiles.rows * frame->tiles.cols);
+    frame->generation = 0;
+    publish(life, frame);
+}
+
+// Every generation is written in a free frame and published, the readers keep the ones they hold
+void lifeStep(Life *life, long long generations){
+    publishDraft(life);
+    for(long long g = 0; g < generations; ++g){
+        const Frame *from = publishedFrame(&life->publisher);
+        Frame *to = takeFrame(&life->publisher);
+        trackTiles(&life->engine, &to->tiles);
+        stepMap(&life->engine, LIFE_ENGINE, &from->map, &to->map, &life->rule);
+        to->generation = from->generation + 1;
+        publish(life, to);
+    }
+    trackTiles(&life->engine, NULL);
+}
+
+long long lifeGeneration(const Life *life){
+    return head(life)->generation;
+}
+
+int lifeRows(const Life *life){
+    return life->rows;
+}
+
+int lifeCols(const Life *life){
+    return life->cols;
+}
+
+static int frameCell(const Frame *frame, int row, int col){
+    const Grid *map = &frame->map;
+    return row >= 0 && col >= 0 && row < map->rows && col < map->cols ? getCell(map, row, col) : DEAD;
+}
+
+int lifeCell(const Life *life, int row, int col){
+    return frameCell(head(life), row, col);
+}
+
+// The cell is seen by the snapshots once it is published (see life.h)
+void lifeSetCell(Life *life, int row, int col, int state){
+    if(row < 0 || col < 0 || row >= life->rows || col >= life->cols || state < 0 || state >= life->rule.states){
+        return;
+    }
+    Frame *frame = draftFrame(life);
+    int old = getCell(&frame->map, row, col);
+    setCell(&frame->map, row, col, state);
+    *tileCount(&frame->tiles, row, col) += (state == ALIVE) - (old == ALIVE);
+}
+
+// States of the rows x cols cells from (row, col), row after row, in cells
+void lifeRegion(const Life *life, int row, int col, int rows, int cols, unsigned char *cells){
+    for(int i = 0; i < rows; ++i){
+        for(int j = 0; j < cols; ++j){
+            cells[(size_t)i * cols + j] = (unsigned char)lifeCell(life, row + i, col + j);
+        }
+    }
+}
+
+// Alive cells of the rows x cols rectangle from (row, col), clipped to the board
+unsigned long long lifePopulation(const Life *life, int row, int col, int rows, int cols){
+    const Frame *frame = head(life);
+    return tilePopulation(&frame->tiles, &frame->map, row, col, rows, cols);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Snapshots ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// The current generation, with the cells set since the last step. NULL if PUBLISH_READERS snapshots are held.
+LifeSnapshot *lifeSnapshot(Life *life){
+    publishDraft(life);
+    return lifeLatest(life);
+}
+
+// The last published generation, from any thread. Never waits for the simulation, which never waits for it.
+LifeSnapshot *lifeLatest(Life *life){
+    return (LifeSnapshot *)readFrame(&life->publisher);
+}
+
+long long lifeSnapshotGeneration(const LifeSnapshot *snapshot){
+    return snapshotFrame(snapshot)->generation;
+}
+
+int lifeSnapshotCell(const LifeSnapshot *snapshot, int row, int col){
+    return frameCell(snapshotFrame(snapshot), row, col);
+}
+
+// Alive cells of the rows x cols rectangle from (row, col), clipped to the board, from the counts of its tiles
+unsigned long long lifeSnapshotPopulation(const LifeSnapshot *snapshot, int row, int col, int rows, int cols){
+    const Frame *frame = snapshotFrame(snapshot);
+    return tilePopulation(&frame->tiles, &frame->map, row, col, rows, cols);
+}
+
+// Go back (or forward) to the generation of the snapshot. Return 1 on success, 0 if the board has another size.
+int lifeRestore(Life *life, const LifeSnapshot *snapshot){
+    const Frame *from = snapshotFrame(snapshot);
+    if(from->map.rows != life->rows || from->map.cols != life->cols){
+        return 0;
+    }
+    Frame *frame = boardFrame(life);
+    copyGrid(&frame->map, &from->map);
+    memcpy(frame->tiles.counts, from->tiles.counts, (size_t)frame->tiles.rows * frame->tiles.cols);
+    frame->generation = from->generation;
+    publish(life, frame);
+    return 1;
+}
+
+// From any thread, the frame of the snapshot can then be reused by the simulation
+void lifeFreeSnapshot(LifeSnapshot *snapshot){
+    if(snapshot != NULL){
+        releaseReader(snapshotReader(snapshot));
+    }
+}
@@ -0,0 +1,66 @@
+/*
+    Description:
+        Simulations of the game of life for programs without a terminal. A Life handle owns everything its
+        simulation needs: the buffers of its generations, the rule, the engine state (lookup table, scratch
+        arenas, statistics) and its own pool of worker threads. Nothing is shared between handles, so independent
+        simulations can be created, stepped and queried from different threads at the same time; a single handle
+        is stepped and edited by one thread at a time, and read by any number of threads through its snapshots.
+        lifeCreate() returns NULL for an empty board or a rule it can't read. Like the rest of the program, it
+        ends the process (exit(1)) when the memory of the generations or the worker threads can't be obtained.
+
+        The cells are addressed (row, col) from the top left corner, their state is 0 (dead), 1 (alive) or 2 to
+        states - 1 (dying cells of a Generations rule). The edges of the board are dead. Cells outside the board
+        read as dead and writes to them are ignored.
+
+        Every generation is published as a snapshot that never changes: the engine writes the next generation
+        in another buffer, so readers on other threads query a consistent board while the simulation moves on.
+        lifeLatest() may be called from any thread and returns the last published generation; lifeSnapshot()
+        first publishes the cells set by lifeSetCell() since the last step (they are published by lifeStep()
+        too). Snapshots answer lifeSnapshotCell() and lifeSnapshotPopulation() from any thread, the population
+        of a rectangle is read from the alive cells of its 8x8 tiles, counted by the engine at every step (see
+        TileCounts in grid.h). Neither side takes a lock nor waits for the other (see publish.h): a snapshot
+        holds its buffer until lifeFreeSnapshot() and the simulation steps into the buffers no one holds. Up to
+        64 snapshots are held at once, lifeLatest() and lifeSnapshot() return NULL beyond. Every snapshot must
+        be freed before lifeDestroy(). lifeRestore() goes back to the generation of a snapshot.
+
+    Example:
+        Life *life = lifeCreate(40, 40, "B3/S23", 1);
+        lifeLoad(life, "patterns/glider.rle", 10, 10);
+        lifeStep(life, 100);
+        unsigned long long alive = lifePopulation(life, 0, 0, 40, 40);
+
+        LifeSnapshot *latest = lifeLatest(life); // From any thread, while another one calls lifeStep()
+        unsigned long long corner = lifeSnapshotPopulation(latest, 0, 0, 20, 20);
+        lifeFreeSnapshot(latest);
+        lifeDestroy(life);
+*/
+
+#ifndef LIFE_H
+#define LIFE_H
+
+typedef struct Life Life;
+typedef struct LifeSnapshot LifeSnapshot;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+Life *lifeCreate(int rows, int cols, const char *rule, int threads);
+void lifeDestroy(Life *life);
+int lifeLoad(Life *life, const char *path, int row, int col);
+void lifeClear(Life *life);
+void lifeStep(Life *life, long long generations);
+long long lifeGeneration(const Life *life);
+int lifeRows(const Life *life);
+int lifeCols(const Life *life);
+int lifeCell(const Life *life, int row, int col);
+void lifeSetCell(Life *life, int row, int col, int state);
+void lifeRegion(const Life *life, int row, int col, int rows, int cols, unsigned char *cells);
+unsigned long long lifePopulation(const Life *life, int row, int col, int rows, int cols);
+
+LifeSnapshot *lifeSnapshot(Life *life);
+LifeSnapshot *lifeLatest(Life *life);
+long long lifeSnapshotGeneration(const LifeSnapshot *snapshot);
+int lifeSnapshotCell(const LifeSnapshot *snapshot, int row, int col);
+unsigned long long lifeSnapshotPopulation(const LifeSnapshot *snapshot, int row, int col, int rows, int cols);
+int lifeRestore(Life *life, const LifeSnapshot *snapshot);
+void lifeFreeSnapshot(LifeSnapshot *snapshot);
+
+#endif
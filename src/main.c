@@ -11,14 +11,32 @@
     Version: 3.1.0
 
     Description: 
-        Game life project for the ECE Paris course "Programmation C". Implementation of the graphics with the PDCurses library.
+        Game life project for the ECE Paris course "Programmation C". Drawn with curses or ANSI escape sequences (see render.h).
     
-    Compilation (PDCurse):
-        debug:      gcc  main.c -o main "pdcurses.a" -Wall -Werror -pedantic
-        release:    gcc  main.c -o main "pdcurses.a" -Wall -Werror -Wextra -pedantic -O3
+    Compilation:
+        cmake:      cmake -S .. -B ../build && cmake --build ../build -j && ctest --test-dir ../build (see CMakeLists.txt
+                    for the native, LTO, PGO and sanitizer builds), or by hand with ncurses (PDCurses: -lpdcurses):
+        debug:      gcc  main.c arena.c engine.c generations.c grid.c history.c input.c export.c jump.c larger.c pace.c pattern.c perf.c prof.c publish.c render.c series.c soup.c threads.c -o main -lncursesw -pthread -Wall -Werror -pedantic
+        release:    gcc  main.c arena.c engine.c generations.c grid.c history.c input.c export.c jump.c larger.c pace.c pattern.c perf.c prof.c publish.c render.c series.c soup.c threads.c -o main -lncursesw -pthread -Wall -Werror -Wextra -pedantic -O3
+        no curses:  add -DNO_CURSES and drop -lncursesw, the terminal is then driven with ANSI escape sequences
+        profiling:  add -DPROFILE to time every phase (status line at the top, report printed on exit)
+                    run with -P to read the hardware counters of the engine (Linux, perf_event_paranoid <= 2)
+        benchmark:  gcc  bench.c arena.c batch.c engine.c generations.c grid.c larger.c perf.c prof.c soup.c threads.c -o bench -pthread -Wall -Werror -Wextra -pedantic -O3
+        test:       gcc  check.c arena.c batch.c engine.c generations.c grid.c history.c larger.c life.c pattern.c perf.c prof.c publish.c soup.c threads.c -o check -pthread -Wall -Werror -Wextra -pedantic -O2
 
     Execution:
-        ./main
+        ./main [-b] [-d density percent] [-e reference|lookup|threaded] [-H generations] [-j threads] [-k every] [-L pattern directory] [-m history MiB] [-o frames.gif|.png] [-p pattern,row,col[,orientation]] [-P] [-r B3/S23|B2/S/C3|B2/S34H|B45/S34L|R5,C0,M1,S34..58,B34..45,NM] [-R curses|ansi|null] [-s generations/s] [-S soup seed] [-t row|tiled|morton] [-T bounded|torus] [-v cells|half|braille] [-x statistics.csv|.bin] [-y none|c2|c4|d2|d4] [-z scale]
+        ./bench [-g generations] [-s size] [-j threads] [-r rule] [-P]
+        -S starts from a random soup of the given seed instead of cells.lvl, of density -d (50% by default) and
+        symmetry -y (none by default)
+        -p stamps a pattern of the library (patterns/ by default, -L) on the map, it can be repeated (see pattern.h)
+        -x writes the population, births and deaths of every generation computed (see series.h), with the bounding
+        box of the alive cells with -b
+        -o draws every -k-th generation computed (every one by default) in an animated GIF or a PNG sequence, with
+        -z pixels per cell (see export.h); -H computes that many generations without a terminal and exits
+        -R draws with curses (default), ANSI escape sequences written directly, or nothing (see render.h)
+        -v draws the alive cells of a square map 2 (half) or 8 (braille) per character instead of one
+        ./check [-n cases] [-g generations] [-s seed]
 
     Sources:
         https://cypris.fr/loisirs/le_jeu_de_la_vie.pdf
@@ -26,202 +44,594 @@
         https://conwaylife.com/wiki/Main_Page
 */
 
-#include <unistd.h> // Sleep function
-#include "curses.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h> // Sleep and getopt functions
+#include "engine.h"
+#include "export.h"
+#include "history.h"
+#include "input.h"
+#include "jump.h"
+#include "pace.h"
+#include "pattern.h"
+#include "perf.h"
+#include "prof.h"
+#include "publish.h"
+#include "render.h"
+#include "series.h"
+#include "soup.h"
+#include "threads.h"
 
 #define MAP_SIZE 40 // /!\ MAKE SURE THE .lvl FILE IS THE SAME SIZE /!\ //
-#define DEAD 0
-#define ALIVE 1
-#define SLEEP_TIME 10 // Milliseconds
+#define SPEED 100 // Generations per second, changed with -s, '+' and '-'
+#define JUMP_THRESHOLD 100 // Longer advances and jumps are computed in the background
+#define JUMP_REFRESH 100   // Milliseconds between two updates of the jump progress
+#define PATTERN_DIRECTORY "patterns"
+#define MAX_PLACEMENTS 16
+#define STATUS_WIDTH 44 // Columns of the longest command line
 
 FILE *file = NULL;
 
 // ~~~~~~~~~~~~~~~~~~~~~~~ Init ~~~~~~~~~~~~~~~~~~~~~~~ //
-int currentGeneration = 0;
+long long currentGeneration = 0; // Generations computed since the level was read
+int paused = 0;
+Pacer pacer;
+View view = VIEW_CELLS;
+BitGrid packedMap; // Alive cells of the map drawn with VIEW_HALF and VIEW_BRAILLE
+char notice[64] = ""; // Answer to the last command, drawn instead of the commands until the next one
 
 // ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
-void initMap(int map[][MAP_SIZE]);
-void updateMap(int map[][MAP_SIZE]);
-void drawMap(int map[][MAP_SIZE]);
-void readLevel(int map[][MAP_SIZE]);
-void drawBorder();
+void drawMap(const Grid *map, Tiling tiling);
+void readLevel(Grid *map);
+void drawBorder(int width);
+void drawProgress(const Jump *jump);
+int mapWidth(Tiling tiling);
+int mapHeight();
 
 // ~~~~~~~~~~~~~~~~~~~~~~~ Main ~~~~~~~~~~~~~~~~~~~~~~~ //
-int main(){
-
-    // Init the terminal with PDcurses
-    initscr(); // Init the screen
-    curs_set(0); // Hide the cursor
-    noecho(); // Don't show the input
-    timeout(0); // Don't wait for the user to press a key (getch() function)
-    resize_term(MAP_SIZE + 6, MAP_SIZE + 4); // Resize the terminal
-
-    // Init the map
-    int map[MAP_SIZE][MAP_SIZE];
-    initMap(map);
-    
-    // Read the level
-    file = fopen("cells.lvl", "r"); // Open the file
-    if(file == NULL){
-        printf("\nERROR: main() function => file variable is null\n");
-        exit(1);
+int main(int argc, char *argv[]){
+
+    // Read the options
+    Rule rule;
+    parseRule(CONWAY_RULE, &rule);
+    GridLayout layout = LAYOUT_ROW_MAJOR;
+    Topology topology = TOPOLOGY_BOUNDED;
+    Engine engine = ENGINE_REFERENCE;
+    int threads = defaultThreadCount();
+    int counters = 0;
+    double speed = SPEED;
+    size_t historyBudget = HISTORY_BUDGET;
+    Soup soup = {0, SOUP_DENSITY, SYMMETRY_NONE};
+    int useSoup = 0;
+    const char *patternDirectory = PATTERN_DIRECTORY;
+    Placement placements[MAX_PLACEMENTS];
+    int placementCount = 0;
+    const char *seriesPath = NULL;
+    const char *exportPath = NULL;
+    ExportOptions exportOptions = {EXPORT_SCALE, EXPORT_DELAY, 1};
+    long long headless = 0; // Generations to compute without a terminal
+    static EngineState engineState; // Lookup table and scratch arenas, too large for the stack
+    initEngineState(&engineState, programPool());
+    Backend backend = DEFAULT_BACKEND;
+    int option;
+    while((option = getopt(argc, argv, "bd:e:H:j:k:L:m:o:p:Pr:R:s:S:t:T:v:x:y:z:")) != -1){
+        int valid = 0;
+        if(option == 'e'){
+            valid = parseEngine(optarg, &engine);
+        }
+        else if(option == 'r'){
+            valid = parseRule(optarg, &rule);
+        }
+        else if(option == 't'){
+            valid = parseLayout(optarg, &layout);
+        }
+        else if(option == 'T'){
+            valid = parseTopology(optarg, &topology);
+        }
+        else if(option == 'j'){
+            threads = atoi(optarg);
+            valid = threads > 0;
+        }
+        else if(option == 'm'){
+            historyBudget = (size_t)(atof(optarg) * (1 << 20));
+            valid = historyBudget > 0;
+        }
+        else if(option == 's'){
+            speed = atof(optarg);
+            valid = speed > 0;
+        }
+        else if(option == 'P'){
+            counters = 1;
+            valid = 1;
+        }
+        else if(option == 'S'){
+            soup.seed = strtoull(optarg, NULL, 0);
+            useSoup = 1;
+            valid = 1;
+        }
+        else if(option == 'd'){
+            soup.density = atof(optarg) / 100;
+            valid = soup.density >= 0 && soup.density <= 1;
+        }
+        else if(option == 'y'){
+            valid = parseSymmetry(optarg, &soup.symmetry);
+        }
+        else if(option == 'L'){
+            patternDirectory = optarg;
+            valid = 1;
+        }
+        else if(option == 'p'){
+            valid = placementCount < MAX_PLACEMENTS && parsePlacement(optarg, &placements[placementCount++]);
+        }
+        else if(option == 'x'){
+            seriesPath = optarg;
+            valid = 1;
+        }
+        else if(option == 'b'){
+            trackBounds(&engineState, 1);
+            valid = 1;
+        }
+        else if(option == 'o'){
+            exportPath = optarg;
+            valid = 1;
+        }
+        else if(option == 'k'){
+            exportOptions.every = atoi(optarg);
+            valid = exportOptions.every > 0;
+        }
+        else if(option == 'z'){
+            exportOptions.scale = atoi(optarg);
+            valid = exportOptions.scale > 0;
+        }
+        else if(option == 'R'){
+            valid = parseBackend(optarg, &backend);
+        }
+        else if(option == 'v'){
+            valid = parseView(optarg, &view);
+        }
+        else if(option == 'H'){
+            headless = atoll(optarg);
+            valid = headless > 0;
+        }
+        if(!valid){
+            printf("\nERROR: main() function => usage: %s [-b] [-d density percent] [-e reference|lookup|threaded] [-H generations] [-j threads] [-k every] [-L pattern directory] [-m history MiB] [-o frames.gif|.png] [-p pattern,row,col[,orientation]] [-P] [-r B3/S23|B2/S/C3|B2/S34H|B45/S34L|R5,C0,M1,S34..58,B34..45,NM] [-R curses|ansi|null] [-s generations/s] [-S soup seed] [-t row|tiled|morton] [-T bounded|torus] [-v cells|half|braille] [-x statistics.csv|.bin] [-y none|c2|c4|d2|d4] [-z scale]\n", argv[0]);
+            exit(1);
+        }
+    }
+#ifdef PROFILE
+    profInit();
+#endif
+    if(counters && !perfInit()){
+        printf("WARNING: hardware counters unavailable (%s), running without them\n", perfError());
+        sleep(1);
     }
-    readLevel(map); // Read the file
+    initEngine(&engineState, engine, &rule); // Tables are built once for the current rule
+    if(engine != JUMP_ENGINE){
+        initEngine(&engineState, JUMP_ENGINE, &rule); // Long jumps always use the fastest engine
+    }
+    startWorkers(threads); // Before the grids so that every worker first touches its own band
+
+    // Init the map and the buffer of the next generation
+    Arena gridArena;
+    initArena(&gridArena, "grids", 0);
+    Grid map, newMap;
+    createGrid(&map, MAP_SIZE, MAP_SIZE, layout, &gridArena, programPool());
+    createGrid(&newMap, MAP_SIZE, MAP_SIZE, layout, &gridArena, programPool());
+    map.topology = newMap.topology = topology;
     
-    while(1){
-        currentGeneration++;
-        drawMap(map);
-        updateMap(map);
-
-        char ch = getch();
-        if(ch == 'p'){
-            while(1){
-                curs_set(1);
-                ch = getch();
-                if(ch == 'p'){
-                    break;
-                }
-            }
-        }
-        if(ch == 'q'){
-            break;
+    // Read the level, or draw a soup
+    BitGrid bits; // Soups and patterns are drawn packed
+    createBitGrid(&bits, MAP_SIZE, MAP_SIZE, &gridArena);
+    if(useSoup){
+        fillSoup(&soup, &bits);
+        unpackGrid(&bits, &map, programPool());
+    }
+    else{
+        file = fopen("cells.lvl", "r"); // Open the file
+        if(file == NULL){
+            printf("\nERROR: main() function => file variable is null\n");
+            exit(1);
         }
+        readLevel(&map); // Read the file
     }
 
-    endwin();
+    // Patterns of the command line, on top of the level
+    PatternLibrary library;
+    initPatternLibrary(&library, patternDirectory, &gridArena);
+    memset(bits.bits, 0, (size_t)bits.rows * bits.words * sizeof(unsigned long long));
+    for(int k = 0; k < placementCount; ++k){
+        if(!placePattern(&library, &placements[k], &bits)){
+            printf("\nERROR: main() function => no pattern %s in %s\n", placements[k].name, patternDirectory);
+            exit(1);
+        }
+    }
+    overlayGrid(&bits, &map);
 
-    return 0;
-}
+    // Statistics of every generation computed, starting with the level
+    Series series;
+    series.file = NULL;
+    StepStats stats;
+    if(seriesPath != NULL){
+        if(!openSeries(&series, seriesPath, &gridArena)){
+            printf("\nERROR: main() function => cannot write %s\n", seriesPath);
+            exit(1);
+        }
+        countStats(&map, &stats);
+        addRecord(&series, currentGeneration, &stats);
+    }
 
-// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Definitions ~~~~~~~~~~~~~~~~~~~~~~~ //
+    // Images of the generations, encoded in the background
+    Exporter exporter;
+    if(exportPath != NULL){
+        if(!openExporter(&exporter, exportPath, MAP_SIZE, MAP_SIZE, &exportOptions, &gridArena, programPool())){
+            printf("\nERROR: main() function => cannot export to %s (.gif or .png)\n", exportPath);
+            exit(1);
+        }
+        exportFrame(&exporter, &map, currentGeneration);
+    }
 
-void initMap(int map[][MAP_SIZE]){
-    for(int i = 0; i < MAP_SIZE; ++i){
-        for(int j = 0; j < MAP_SIZE; ++j){
-            map[i][j] = DEAD;
+    if(headless){
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(long long g = 0; g < headless; ++g){
+            stepMap(&engineState, engine, &map, &newMap, &rule);
+            swapGrids(&map, &newMap);
+            currentGeneration++;
+            if(series.file != NULL){
+                stepStats(&engineState, &stats);
+                addRecord(&series, currentGeneration, &stats);
+            }
+            if(exportPath != NULL){
+                exportFrame(&exporter, &map, currentGeneration);
+            }
         }
+        if(exportPath != NULL){
+            closeExporter(&exporter);
+        }
+        closeSeries(&series);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%lld generations in %.3f s", currentGeneration, seconds);
+        if(exportPath != NULL){
+            printf(", %lld frames written to %s", exporter.written, exportPath);
+        }
+        printf("\n");
+        freeEngineState(&engineState);
+        freeArena(&gridArena);
+        stopWorkers();
+        return 0;
     }
-}
 
-void updateMap(int map[][MAP_SIZE]){
-    int newMap[MAP_SIZE][MAP_SIZE]; // We create a new map to not modify the current one
-    initMap(newMap);
+    // Init the terminal, sized for the map and the status lines
+    if(view != VIEW_CELLS && rule.tiling != TILING_SQUARE){
+        printf("\nERROR: main() function => the half and braille views only draw square cells\n");
+        exit(1);
+    }
+    createBitGrid(&packedMap, MAP_SIZE, MAP_SIZE, &gridArena);
+    int width = mapWidth(rule.tiling) + 3;
+    Arena screenArena;
+    initArena(&screenArena, "screen", 0);
+    initRenderer(backend, mapHeight() + 7, width > STATUS_WIDTH ? width : STATUS_WIDTH, &screenArena);
+    initInput(mapHeight() + 5); // Don't show the input, the jump prompt replaces the last line
 
-    for(int i = 0; i < MAP_SIZE; ++i){
-        for(int j = 0; j < MAP_SIZE; ++j){
-            int countNeighbour = 0;
+    // Generations already computed are replayed from the history instead
+    History history;
+    initHistory(&history, MAP_SIZE, MAP_SIZE, historyBudget, &gridArena);
+    recordGeneration(&history, &map, currentGeneration);
 
-            // We count the number of neighbours
-            if((i > 0) && (map[i - 1][j] == ALIVE)){ // Left cell
-                countNeighbour++;
+    // First generation of the timeline (the level, or the last edit): the generations the history forgot are
+    // computed again from it
+    Grid origin;
+    createGrid(&origin, MAP_SIZE, MAP_SIZE, layout, &gridArena, programPool());
+    origin.topology = topology;
+    copyGrid(&origin, &map);
+    long long originGeneration = currentGeneration;
+
+    // Generations of the jumps, drawn while the next ones are computed
+    Publisher publisher;
+    initPublisher(&publisher, MAP_SIZE, MAP_SIZE, layout, topology, programPool());
+    Jump jump;
+    jump.running = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    initPacer(&pacer, speed);
+    while(1){
+        if(jump.running){
+            // The jump thread owns the grids, the last generation it published is drawn until it is done
+            Command command = waitCommand(JUMP_REFRESH);
+            if(command.type == COMMAND_QUIT || command.type == COMMAND_PAUSE){
+                cancelJump(&jump);
             }
-            if((i > 0) && (j > 0) && (map[i - 1][j - 1] == ALIVE)){ // Top Left cell
-                countNeighbour++;
+            if(jumpDone(&jump)){
+                currentGeneration += jumpProgress(&jump);
+                recordGeneration(&history, &map, currentGeneration);
+                PROF_GENERATION();
+                perfEndGeneration();
+                resetPacer(&pacer);
             }
-            if((j > 0) && (map[i][j - 1] == ALIVE)){ // Top cell
-                countNeighbour++;
+            else{
+                Reader *reader = readFrame(&publisher);
+                if(reader != NULL){
+                    drawMap(&readerFrame(reader)->map, rule.tiling);
+                    releaseReader(reader);
+                }
+                drawProgress(&jump);
             }
-            if((j > 0) && (i < MAP_SIZE - 1) && (map[i + 1][j - 1] == ALIVE)){ // Top Right cell
-                countNeighbour++;
+            if(command.type == COMMAND_QUIT){
+                break;
             }
+            continue;
+        }
 
-            if((i < (MAP_SIZE - 1)) && (map[i + 1][j] == ALIVE)){ // Right cell
-                countNeighbour++;
+        drawMap(&map, rule.tiling);
+        PROF_START(PHASE_REFRESH);
+        presentFrame();
+        PROF_STOP(PHASE_REFRESH);
+
+        // The wait until the next frame is due is spent in getch(), paused it only returns on a key
+        PROF_START(PHASE_SLEEP);
+        Command command = waitCommand(paused ? WAIT_FOREVER : pacerTimeout(&pacer));
+        PROF_STOP(PHASE_SLEEP);
+
+        PROF_START(PHASE_INPUT);
+        int paced = !paused && pacerDue(&pacer); // Else a key ended the wait early
+        long long steps = paced ? pacerSteps(&pacer) : 0;
+        if(command.type != COMMAND_NONE){
+            notice[0] = '\0';
+        }
+        if(command.type == COMMAND_QUIT){
+            break;
+        }
+        else if(command.type == COMMAND_PAUSE){
+            paused = !paused;
+            paced = 0;
+            steps = 0;
+            resetPacer(&pacer);
+        }
+        else if(command.type == COMMAND_STEP){
+            paused = 1;
+            paced = 0;
+            steps = 1;
+        }
+        else if(command.type == COMMAND_BACK){
+            paused = 1;
+            paced = 0;
+            steps = 0;
+            if(restoreGeneration(&history, &map, currentGeneration, currentGeneration - 1)){
+                currentGeneration--;
             }
-            if((i < (MAP_SIZE - 1)) && (j < (MAP_SIZE - 1)) && (map[i + 1][j + 1] == ALIVE)){ // Bottom Right cell
-                countNeighbour++;
+        }
+        else if(command.type == COMMAND_FASTER){
+            setPacerSpeed(&pacer, pacer.speed * 2);
+        }
+        else if(command.type == COMMAND_SLOWER){
+            setPacerSpeed(&pacer, pacer.speed / 2);
+        }
+        else if(command.type == COMMAND_ADVANCE){
+            paced = 0;
+            steps = command.value;
+        }
+        else if(command.type == COMMAND_JUMP){
+            paced = 0;
+            steps = command.value > currentGeneration ? command.value - currentGeneration : 0;
+            if(command.value < currentGeneration && restoreGeneration(&history, &map, currentGeneration, command.value)){
+                currentGeneration = command.value; // Back in the history
             }
-            if((j < (MAP_SIZE - 1)) && (map[i][j + 1] == ALIVE)){ // Bottom cell
-                countNeighbour++;
+            else if(command.value < currentGeneration && command.value >= originGeneration){
+                // Forgotten by the history: computed again from the start of the timeline, in the background if far
+                copyGrid(&map, &origin);
+                currentGeneration = originGeneration;
+                steps = command.value - originGeneration;
+                clearHistory(&history);
+                recordGeneration(&history, &map, currentGeneration);
             }
-            if((i < (MAP_SIZE - 1)) && (j < (MAP_SIZE - 1)) && map[i - 1][j + 1] == ALIVE){ // Bottom Left cell
-                countNeighbour++;
+            else if(command.value < currentGeneration){
+                snprintf(notice, sizeof(notice), "Generation %lld is no longer in the history", command.value);
             }
-
-            // /*\ /*\ /*\ /*\ RULES /*\ /*\ /*\ /*\ //
-
-            if(map[i][j] == ALIVE){
-                if(countNeighbour < 2 || countNeighbour > 3){
-                    newMap[i][j] = DEAD; // Die because of underpopulation or overpopulation
-                }
-                else{
-                    newMap[i][j] = ALIVE; // Survive
+        }
+        else if(command.type == COMMAND_PLACE){
+            // The map changes under the current generation: the history starts again from it
+            Placement placement;
+            memset(bits.bits, 0, (size_t)bits.rows * bits.words * sizeof(unsigned long long));
+            if(parsePlacement(command.text, &placement) && placePattern(&library, &placement, &bits)){
+                overlayGrid(&bits, &map);
+                recordGeneration(&history, &map, currentGeneration);
+                copyGrid(&origin, &map);
+                originGeneration = currentGeneration;
+                if(series.file != NULL){
+                    countStats(&map, &stats); // The edited generation is written again
+                    addRecord(&series, currentGeneration, &stats);
                 }
             }
-            else{
-                if(countNeighbour == 3){
-                    newMap[i][j] = ALIVE; // Become alive because of reproduction
-                }
-                else{
-                    newMap[i][j] = DEAD; // Stay dead
-                }
+            paced = 0;
+            steps = 0;
+        }
+        PROF_STOP(PHASE_INPUT);
+
+        if(!paced && steps > 1 && restoreGeneration(&history, &map, currentGeneration, currentGeneration + steps)){
+            currentGeneration += steps; // Forward in the history
+            steps = 0;
+        }
+        // Paced frames are stepped here whatever their size (see pacerSteps()), only advances and jumps go to
+        // the background
+        if(!paced && steps > JUMP_THRESHOLD && currentGeneration + steps > newestGeneration(&history)){
+            startJump(&jump, &engineState, &map, &publisher, &rule, steps, series.file != NULL ? &series : NULL,
+                      exportPath != NULL ? &exporter : NULL, currentGeneration);
+            steps = 0;
+        }
+        for(long long s = 0; s < steps; ++s){
+            if(restoreGeneration(&history, &map, currentGeneration, currentGeneration + 1)){
+                currentGeneration++; // Replayed
+                continue;
+            }
+            PROF_START(PHASE_UPDATE);
+            stepMap(&engineState, engine, &map, &newMap, &rule);
+            swapGrids(&map, &newMap);
+            PROF_STOP(PHASE_UPDATE);
+            currentGeneration++;
+            recordGeneration(&history, &map, currentGeneration);
+            if(series.file != NULL){
+                stepStats(&engineState, &stats);
+                addRecord(&series, currentGeneration, &stats);
+            }
+            if(exportPath != NULL){
+                exportFrame(&exporter, &map, currentGeneration);
             }
+            PROF_GENERATION();
+            perfEndGeneration();
+        }
+        if(paced){
+            pacerFrame(&pacer, (int)steps);
         }
     }
 
-    // Copy of newMap into map
-    for(int i = 0; i < MAP_SIZE; ++i){
-        for(int j = 0; j < MAP_SIZE; ++j){
-            map[i][j] = newMap[i][j];
-        }
+    cancelJump(&jump);
+    freePublisher(&publisher);
+    closeSeries(&series);
+    if(exportPath != NULL){
+        closeExporter(&exporter);
+    }
+    endRenderer();
+    freeArena(&screenArena);
+    if(backend == BACKEND_NULL){
+        // Nothing was drawn, the generations reached tell how fast the loop ran
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%lld generations in %.3f s\n", currentGeneration, seconds);
     }
+#ifdef PROFILE
+    profReport();
+#endif
+    if(counters){
+        perfReport(currentGeneration);
+    }
+    freeEngineState(&engineState);
+    freeArena(&gridArena);
+    stopWorkers();
+
+    return 0;
 }
 
-void drawMap(int map[][MAP_SIZE]){
-    clear();
-    drawBorder();
-    mvprintw(1, 1, "Generation: %d", currentGeneration);
-    for(int i = 0; i < MAP_SIZE; ++i){
-        for(int j = 0; j < MAP_SIZE; ++j){
-            if(map[i][j] == DEAD)
-                mvprintw(i + 3, j + 1, "%c ", 32u); // 32u is the code for the character " "
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Definitions ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Hexagonal cells are drawn every other column so that odd rows can be shifted by half a cell, triangles pointing
+// up and down alternate in a row like square cells. The caller presents the frame.
+void drawMap(const Grid *map, Tiling tiling){
+    clearScreen();
+    PROF_START(PHASE_DRAW_BORDER);
+    drawBorder(mapWidth(tiling));
+    PROF_STOP(PHASE_DRAW_BORDER);
+    if(paused)
+        drawText(1, 1, "Generation: %lld  paused", currentGeneration);
+    else
+        drawText(1, 1, "Generation: %lld  %.0f/%.0f gen/s", currentGeneration, pacer.achieved, pacer.speed);
+    if(perfEnabled()){
+        char status[MAP_SIZE + 2];
+        perfStatus(status, sizeof(status));
+        drawText(mapHeight() + 6, 1, "%s", status);
+    }
+#ifdef PROFILE
+    char status[MAP_SIZE + 4];
+    profStatus(status, sizeof(status));
+    drawText(0, 1, "%s", status);
+#endif
+    PROF_START(PHASE_DRAW_MAP);
+    if(view != VIEW_CELLS){
+        packGrid(map, &packedMap, programPool());
+        drawPacked(3, 1, &packedMap, view);
+    }
+    for(int i = 0; i < map->rows && view == VIEW_CELLS; ++i){
+        for(int j = 0; j < map->cols; ++j){
+            int state = getCell(map, i, j);
+            if(tiling == TILING_HEX){
+                if(state != DEAD)
+                    drawGlyph(i + 3, 2 * j + 1 + i % 2, state == ALIVE ? GLYPH_ALIVE : GLYPH_DYING);
+            }
+            else if(tiling == TILING_TRIANGULAR){
+                if(state == ALIVE)
+                    drawGlyph(i + 3, j + 1, (i + j) % 2 == 0 ? GLYPH_UP : GLYPH_DOWN);
+                else if(state != DEAD)
+                    drawGlyph(i + 3, j + 1, GLYPH_DYING);
+            }
+            else if(state == DEAD)
+                drawGlyph(i + 3, j + 1, GLYPH_DEAD);
+            else if(state == ALIVE)
+                drawGlyph(i + 3, j + 1, GLYPH_ALIVE);
             else
-                mvprintw(i + 3, j + 1, "%c ", 248u); // 254u is the code for the character "°"
+                drawGlyph(i + 3, j + 1, GLYPH_DYING); // Dying cell of a Generations rule
         }
     }
-    // Pause button
-    mvprintw(MAP_SIZE + 4, 1, "Press 'p' to pause");
-    mvprintw(MAP_SIZE + 5, 1, "Press 'q' to quit");
-    refresh();
-    usleep(SLEEP_TIME * 1000);
+    // Commands
+    if(paused)
+        drawText(mapHeight() + 4, 1, "Paused: 'p' resume, 's' step, 'b' back");
+    else
+        drawText(mapHeight() + 4, 1, "'p' pause, '+'/'-' speed");
+    if(notice[0] != '\0')
+        drawText(mapHeight() + 5, 1, "%s", notice);
+    else
+        drawText(mapHeight() + 5, 1, "'n' advance, 'g' jump, 'i' insert, 'q' quit");
+    PROF_STOP(PHASE_DRAW_MAP);
+}
+
+void drawProgress(const Jump *jump){
+    long long done = jumpProgress(jump);
+    clearLine(1, 1);
+    drawText(1, 1, "Generation: %lld -> %lld (%lld%%)", currentGeneration + done, currentGeneration + jump->generations,
+             100 * done / jump->generations);
+    presentFrame();
+}
+
+// Number of terminal columns inside the border
+int mapWidth(Tiling tiling){
+    int rows, cols;
+    viewSize(view, MAP_SIZE, MAP_SIZE, &rows, &cols);
+    return view != VIEW_CELLS ? cols : tiling == TILING_HEX ? 2 * MAP_SIZE + 1 : MAP_SIZE + 1;
+}
+
+// Number of terminal rows inside the border
+int mapHeight(){
+    int rows, cols;
+    viewSize(view, MAP_SIZE, MAP_SIZE, &rows, &cols);
+    return rows;
 }
 
-void drawBorder(){
+void drawBorder(int width){
     // Corners
-    mvprintw(2, 0, "%c", 201u);
-    mvprintw(2, MAP_SIZE + 2, "%c", 187u);
-    mvprintw(MAP_SIZE + 3, 0, "%c", 200u);
-    mvprintw(MAP_SIZE + 3, MAP_SIZE + 2, "%c", 188u);
+    drawGlyph(2, 0, GLYPH_TOP_LEFT);
+    drawGlyph(2, width + 1, GLYPH_TOP_RIGHT);
+    drawGlyph(mapHeight() + 3, 0, GLYPH_BOTTOM_LEFT);
+    drawGlyph(mapHeight() + 3, width + 1, GLYPH_BOTTOM_RIGHT);
 
     // Top and bottom
-    for(int i = 1; i <= MAP_SIZE + 1; ++i){
-        mvprintw(2, i, "%c", 205u);
-        mvprintw(MAP_SIZE + 3, i, "%c", 205u);
+    for(int i = 1; i <= width; ++i){
+        drawGlyph(2, i, GLYPH_HORIZONTAL);
+        drawGlyph(mapHeight() + 3, i, GLYPH_HORIZONTAL);
     }
 
     // Left and right
-    for(int i = 3; i < MAP_SIZE + 3; ++i){
-        mvprintw(i, 0, "%c", 186u);
-        mvprintw(i, MAP_SIZE + 2, "%c", 186u);
+    for(int i = 3; i < mapHeight() + 3; ++i){
+        drawGlyph(i, 0, GLYPH_VERTICAL);
+        drawGlyph(i, width + 1, GLYPH_VERTICAL);
     }
 }
 
-void readLevel(int map[][MAP_SIZE]){
+void readLevel(Grid *map){
     if(file == NULL){
         printf("\nERROR: readLevel() function => file variable is null\n");
         exit(1);
     }
     
     char c = ' ';
-    for(int i = 0; i < MAP_SIZE; ++i){
-        for(int j = 0; j < MAP_SIZE + 1; j++){
+    for(int i = 0; i < map->rows; ++i){
+        for(int j = 0; j < map->cols + 1; j++){
             c = fgetc(file);
-            if(c != '\n'){
+            if(c != '\n' && j < map->cols){
                 if(c == '1'){
-                    map[i][j] = ALIVE;
+                    setCell(map, i, j, ALIVE);
                 }
                 else if(c == '0'){
-                    map[i][j] = DEAD;
+                    setCell(map, i, j, DEAD);
                 }
                 else if(c == EOF){
                     break;
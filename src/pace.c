@@ -0,0 +1,70 @@
+/*
+    Description:
+        Frame scheduler of the interactive program (see pace.h).
+*/
+
+#include <time.h>
+#include "pace.h"
+
+#define NANOSECONDS 1000000000ll
+
+static long long nanoseconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * NANOSECONDS + now.tv_nsec;
+}
+
+// Duration of a frame of pacerSteps() generations
+static long long framePeriod(const Pacer *pacer){
+    return (long long)(pacerSteps(pacer) * NANOSECONDS / pacer->speed);
+}
+
+void initPacer(Pacer *pacer, double speed){
+    pacer->achieved = 0.0;
+    setPacerSpeed(pacer, speed);
+}
+
+void setPacerSpeed(Pacer *pacer, double speed){
+    pacer->speed = speed < MIN_SPEED ? MIN_SPEED : speed > MAX_SPEED ? MAX_SPEED : speed;
+    resetPacer(pacer);
+}
+
+// Restart the schedule from now, after a pause or a jump
+void resetPacer(Pacer *pacer){
+    pacer->nextFrame = nanoseconds();
+    pacer->windowStart = pacer->nextFrame;
+    pacer->windowGenerations = 0;
+}
+
+// Generations computed by a frame, up to MAX_SPEED / MAX_FRAME_RATE: the caller steps them inline, never as a
+// background jump
+int pacerSteps(const Pacer *pacer){
+    int steps = (int)(pacer->speed / MAX_FRAME_RATE + 0.999);
+    return steps > 1 ? steps : 1;
+}
+
+// Milliseconds left before the next frame, rounded up so the wait never ends before the deadline
+int pacerTimeout(const Pacer *pacer){
+    long long left = pacer->nextFrame - nanoseconds();
+    return left > 0 ? (int)((left + 999999) / 1000000) : 0;
+}
+
+int pacerDue(const Pacer *pacer){
+    return nanoseconds() >= pacer->nextFrame;
+}
+
+// The generations of a frame were computed
+void pacerFrame(Pacer *pacer, int generations){
+    long long now = nanoseconds();
+    pacer->nextFrame += framePeriod(pacer);
+    if(pacer->nextFrame < now){
+        pacer->nextFrame = now; // Late: the work costs more than a frame, go as fast as possible
+    }
+
+    pacer->windowGenerations += generations;
+    if(now - pacer->windowStart >= NANOSECONDS){
+        pacer->achieved = (double)pacer->windowGenerations * NANOSECONDS / (double)(now - pacer->windowStart);
+        pacer->windowStart = now;
+        pacer->windowGenerations = 0;
+    }
+}
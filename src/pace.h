@@ -0,0 +1,36 @@
+/*
+    Description:
+        Frame scheduler of the interactive program. The user asks for a speed in generations per second, the
+        pacer gives the time left before the next frame is due, measured from a deadline rather than after the
+        work: the cost of computing and drawing a frame is taken from the wait instead of being added to it.
+        Above MAX_FRAME_RATE generations per second a frame computes several generations, the screen isn't
+        redrawn faster than that. Even at MAX_SPEED a frame is stepped inline by the main loop (about 16700
+        generations), it never becomes a background jump. When a frame is late the schedule restarts from now
+        instead of bursting to catch up. The speed actually achieved is measured over the last second for the
+        status line.
+*/
+
+#ifndef PACE_H
+#define PACE_H
+
+#define MAX_FRAME_RATE 60
+#define MIN_SPEED 0.25
+#define MAX_SPEED 1e6
+
+typedef struct Pacer{
+    double speed;                 // Requested generations per second
+    long long nextFrame;          // Deadline of the next frame, nanoseconds
+    long long windowStart;        // Start of the current measure of the achieved speed
+    long long windowGenerations;  // Generations computed since windowStart
+    double achieved;              // Generations per second over the last measure
+} Pacer;
+
+void initPacer(Pacer *pacer, double speed);
+void setPacerSpeed(Pacer *pacer, double speed);
+void resetPacer(Pacer *pacer);
+int pacerSteps(const Pacer *pacer);
+int pacerTimeout(const Pacer *pacer);
+int pacerDue(const Pacer *pacer);
+void pacerFrame(Pacer *pacer, int generations);
+
+#endif
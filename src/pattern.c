@@ -0,0 +1,304 @@
+/*
+    Description:
+        Library of named patterns stamped onto a board (see pattern.h).
+
+    Sources:
+        https://conwaylife.com/wiki/Run_Length_Encoded
+        https://conwaylife.com/wiki/Gosper_glider_gun
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pattern.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Parsing ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Read an orientation ("0", "90", "180" or "270", "m" suffix to mirror). Return 1 on success, 0 otherwise.
+int parseOrientation(const char *text, int *orientation){
+    static const char *turns[] = {"0", "90", "180", "270"};
+    size_t length = strlen(text);
+    int mirror = length > 0 && text[length - 1] == 'm';
+    for(int k = 0; k < 4; ++k){
+        if(strlen(turns[k]) == length - mirror && strncmp(text, turns[k], length - mirror) == 0){
+            *orientation = k | (mirror ? ORIENTATION_MIRROR : 0);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Read "name,row,col[,orientation]". Return 1 on success, 0 otherwise.
+int parsePlacement(const char *text, Placement *placement){
+    const char *comma = strchr(text, ',');
+    if(comma == NULL || comma == text || comma - text >= PATTERN_NAME_SIZE){
+        return 0;
+    }
+    memcpy(placement->name, text, comma - text);
+    placement->name[comma - text] = '\0';
+
+    char *end;
+    placement->row = (int)strtol(comma + 1, &end, 10);
+    if(end == comma + 1 || *end != ','){
+        return 0;
+    }
+    const char *colText = end + 1;
+    placement->col = (int)strtol(colText, &end, 10);
+    if(end == colText){
+        return 0;
+    }
+    placement->orientation = 0;
+    if(*end == ','){
+        return parseOrientation(end + 1, &placement->orientation);
+    }
+    return *end == '\0';
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Loading ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Names are file names without a directory, so a placement can't read outside of the library
+static int validName(const char *name){
+    if(*name == '\0'){
+        return 0;
+    }
+    for(const char *c = name; *c != '\0'; ++c){
+        if(!isalnum((unsigned char)*c) && *c != '_' && *c != '-'){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Body of an RLE file: <count><tag> with b or . dead, o or A alive, $ next row, ! end. The other letters are the
+// dying states of a Generations pattern, stamped dead.
+static int readRle(FILE *input, Pattern *pattern, Arena *arena){
+    int c;
+    char line[PATTERN_PATH_SIZE];
+    while((c = fgetc(input)) == '#'){
+        if(fgets(line, sizeof(line), input) == NULL){
+            return 0;
+        }
+    }
+    ungetc(c, input);
+    if(fgets(line, sizeof(line), input) == NULL || sscanf(line, " x = %d , y = %d", &pattern->cols, &pattern->rows) != 2){
+        return 0;
+    }
+    if(pattern->rows <= 0 || pattern->cols <= 0){
+        return 0;
+    }
+    pattern->cells = arenaAlloc(arena, (size_t)pattern->rows * pattern->cols, 1);
+    memset(pattern->cells, 0, (size_t)pattern->rows * pattern->cols);
+
+    int i = 0, j = 0, count = 0;
+    while((c = fgetc(input)) != EOF && c != '!'){
+        if(isdigit(c)){
+            count = count * 10 + (c - '0');
+            continue;
+        }
+        if(isspace(c)){
+            continue;
+        }
+        int run = count > 0 ? count : 1;
+        count = 0;
+        if(c == '$'){
+            i += run;
+            j = 0;
+        }
+        else if(c != 'o' && c != 'A' && (isalpha(c) || c == '.')){
+            j += run;
+        }
+        else if(c == 'o' || c == 'A'){
+            for(int k = 0; k < run; ++k, ++j){
+                if(i >= pattern->rows || j >= pattern->cols){
+                    return 0;
+                }
+                pattern->cells[(size_t)i * pattern->cols + j] = 1;
+            }
+        }
+        else{
+            return 0;
+        }
+    }
+    return c == '!';
+}
+
+// Rows of 0 and 1 like cells.lvl, the longest row gives the width
+static int readLevelPattern(FILE *input, Pattern *pattern, Arena *arena){
+    int rows = 0, cols = 0, length = 0, c;
+    while((c = fgetc(input)) != EOF){
+        if(c == '\n'){
+            rows += length > 0;
+            length = 0;
+        }
+        else if(c == '0' || c == '1'){
+            cols = ++length > cols ? length : cols;
+        }
+        else if(c != '\r'){
+            return 0;
+        }
+    }
+    rows += length > 0;
+    if(rows == 0){
+        return 0;
+    }
+    pattern->rows = rows;
+    pattern->cols = cols;
+    pattern->cells = arenaAlloc(arena, (size_t)rows * cols, 1);
+    memset(pattern->cells, 0, (size_t)rows * cols);
+
+    rewind(input);
+    int i = 0, j = 0;
+    while((c = fgetc(input)) != EOF){
+        if(c == '\n'){
+            i += j > 0;
+            j = 0;
+        }
+        else if(c == '0' || c == '1'){
+            pattern->cells[(size_t)i * cols + j++] = (unsigned char)(c == '1');
+        }
+    }
+    return 1;
+}
+
+void initPatternLibrary(PatternLibrary *library, const char *directory, Arena *arena){
+    snprintf(library->directory, sizeof(library->directory), "%s", directory);
+    library->arena = arena;
+    library->first = NULL;
+}
+
+// Read the pattern of a .rle file, or of a .lvl file for any other extension. Return 1 on success, 0 otherwise.
+int readPattern(const char *path, Pattern *pattern, Arena *arena){
+    FILE *input = fopen(path, "r");
+    if(input == NULL){
+        return 0;
+    }
+    size_t length = strlen(path);
+    memset(pattern, 0, sizeof(*pattern));
+    int rle = length > 4 && strcmp(path + length - 4, ".rle") == 0;
+    int valid = rle ? readRle(input, pattern, arena) : readLevelPattern(input, pattern, arena);
+    fclose(input);
+    return valid;
+}
+
+// Pattern read from the library directory the first time it is asked for, NULL if there is no valid file
+Pattern *findPattern(PatternLibrary *library, const char *name){
+    for(Pattern *pattern = library->first; pattern != NULL; pattern = pattern->next){
+        if(strcmp(pattern->name, name) == 0){
+            return pattern;
+        }
+    }
+    if(!validName(name) || strlen(name) >= PATTERN_NAME_SIZE){
+        return NULL;
+    }
+
+    static const char *extensions[] = {"rle", "lvl"};
+    ArenaMark mark = arenaMark(library->arena);
+    Pattern *pattern = arenaAlloc(library->arena, sizeof(Pattern), CACHE_LINE);
+    memset(pattern, 0, sizeof(*pattern));
+    snprintf(pattern->name, sizeof(pattern->name), "%s", name);
+    for(int e = 0; e < 2; ++e){
+        char path[PATTERN_PATH_SIZE + PATTERN_NAME_SIZE + 8];
+        snprintf(path, sizeof(path), "%s/%s.%s", library->directory, name, extensions[e]);
+        FILE *input = fopen(path, "r");
+        if(input == NULL){
+            continue;
+        }
+        int valid = e == 0 ? readRle(input, pattern, library->arena) : readLevelPattern(input, pattern, library->arena);
+        fclose(input);
+        if(valid){
+            pattern->next = library->first;
+            library->first = pattern;
+            return pattern;
+        }
+        break;
+    }
+    arenaRelease(library->arena, mark);
+    return NULL;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Stamping ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+void orientedSize(const Pattern *pattern, int orientation, int *rows, int *cols){
+    int turned = orientation & 1;
+    *rows = turned ? pattern->cols : pattern->rows;
+    *cols = turned ? pattern->rows : pattern->cols;
+}
+
+static int maskWords(int cols){
+    return (cols + 63) / 64 + 1; // A row shifted by up to 63 bits spills into one more word
+}
+
+// masks[shift * rows + i] is row i of the oriented pattern shifted left by shift bits
+static unsigned long long *buildMasks(const Pattern *pattern, int orientation, Arena *arena){
+    int rows, cols;
+    orientedSize(pattern, orientation, &rows, &cols);
+    int words = maskWords(cols);
+    size_t rowSize = (size_t)words * sizeof(unsigned long long);
+    unsigned long long *masks = arenaAlloc(arena, 64 * rows * rowSize, CACHE_LINE);
+    memset(masks, 0, 64 * rows * rowSize);
+
+    // Mirror the columns, then turn the cell a quarter clockwise at a time: (i, j) of h x w goes to (j, h - 1 - i)
+    for(int i = 0; i < pattern->rows; ++i){
+        for(int j = 0; j < pattern->cols; ++j){
+            if(!pattern->cells[(size_t)i * pattern->cols + j]){
+                continue;
+            }
+            int r = i, c = orientation & ORIENTATION_MIRROR ? pattern->cols - 1 - j : j;
+            int height = pattern->rows, width = pattern->cols;
+            for(int turn = 0; turn < (orientation & 3); ++turn){
+                int turned = c;
+                c = height - 1 - r;
+                r = turned;
+                turned = height;
+                height = width;
+                width = turned;
+            }
+            masks[(size_t)r * words + (c >> 6)] |= 1ull << (c & 63);
+        }
+    }
+
+    for(int shift = 1; shift < 64; ++shift){
+        for(int i = 0; i < rows; ++i){
+            const unsigned long long *base = masks + (size_t)i * words;
+            unsigned long long *shifted = masks + ((size_t)shift * rows + i) * words;
+            shifted[0] = base[0] << shift;
+            for(int w = 1; w < words; ++w){
+                shifted[w] = base[w] << shift | base[w - 1] >> (64 - shift);
+            }
+        }
+    }
+    return masks;
+}
+
+// OR the alive cells of the oriented pattern into the grid, its top left corner on (row, col)
+void stampPattern(PatternLibrary *library, Pattern *pattern, int orientation, BitGrid *grid, int row, int col){
+    if(pattern->masks[orientation] == NULL){
+        pattern->masks[orientation] = buildMasks(pattern, orientation, library->arena);
+    }
+    int rows, cols;
+    orientedSize(pattern, orientation, &rows, &cols);
+    int words = maskWords(cols);
+    int shift = col & 63;            // Also for a negative column: two's complement
+    int firstWord = (col - shift) / 64; // Word of the grid under the first word of a mask, maybe negative
+    int tail = grid->cols & 63;
+    unsigned long long lastMask = tail ? (1ull << tail) - 1 : ~0ull;
+
+    for(int i = row < 0 ? -row : 0; i < rows && row + i < grid->rows; ++i){
+        const unsigned long long *mask = pattern->masks[orientation] + ((size_t)shift * rows + i) * words;
+        unsigned long long *target = bitRow(grid, row + i);
+        for(int w = firstWord < 0 ? -firstWord : 0; w < words && firstWord + w < grid->words; ++w){
+            target[firstWord + w] |= firstWord + w == grid->words - 1 ? mask[w] & lastMask : mask[w];
+        }
+    }
+}
+
+// Stamp a placement. Return 1 on success, 0 if the pattern isn't in the library.
+int placePattern(PatternLibrary *library, const Placement *placement, BitGrid *grid){
+    Pattern *pattern = findPattern(library, placement->name);
+    if(pattern == NULL){
+        return 0;
+    }
+    stampPattern(library, pattern, placement->orientation, grid, placement->row, placement->col);
+    return 1;
+}
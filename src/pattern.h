@@ -0,0 +1,64 @@
+/*
+    Description:
+        Library of named patterns (gliders, guns, ...) stamped onto a board. A pattern is read once from
+        <directory>/<name>.rle (the run-length format of LifeWiki) or <directory>/<name>.lvl (rows of 0 and 1,
+        like cells.lvl), then kept for the rest of the run.
+
+        Only the alive cells of a pattern are kept (the dying states of a Generations pattern are dead).
+        A pattern is stamped with its alive cells ORed into a BitGrid a word at a time: for every orientation it
+        is used in, its rows are stored once shifted by each of the 64 bit alignments, so stamping at any column
+        is a copy of whole precomputed words, without shifting. Cells falling outside the board are clipped.
+
+        Orientations: a number of clockwise quarter turns, after a left-right mirror when ORIENTATION_MIRROR is
+        set. They are written "0", "90", "180" or "270", followed by "m" for the mirrored ones.
+
+        A placement is written "name,row,col[,orientation]": the top left corner of the oriented pattern goes on
+        cell (row, col).
+
+    Sources:
+        https://conwaylife.com/wiki/Run_Length_Encoded
+*/
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include "grid.h"
+
+#define PATTERN_NAME_SIZE 32
+#define PATTERN_PATH_SIZE 256
+#define ORIENTATIONS 8
+#define ORIENTATION_MIRROR 4 // Quarter turns are the two low bits
+
+typedef struct Pattern{
+    char name[PATTERN_NAME_SIZE];
+    int rows;
+    int cols;
+    unsigned char *cells;                    // rows * cols, 1 for the alive cells
+    unsigned long long *masks[ORIENTATIONS]; // Shifted rows of every orientation, NULL until it is first used
+    struct Pattern *next;
+} Pattern;
+
+typedef struct PatternLibrary{
+    char directory[PATTERN_PATH_SIZE];
+    Arena *arena; // Patterns and masks live as long as it
+    Pattern *first;
+} PatternLibrary;
+
+typedef struct Placement{
+    char name[PATTERN_NAME_SIZE];
+    int row;
+    int col;
+    int orientation;
+} Placement;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int parseOrientation(const char *text, int *orientation);
+int parsePlacement(const char *text, Placement *placement);
+int readPattern(const char *path, Pattern *pattern, Arena *arena);
+void initPatternLibrary(PatternLibrary *library, const char *directory, Arena *arena);
+Pattern *findPattern(PatternLibrary *library, const char *name);
+void orientedSize(const Pattern *pattern, int orientation, int *rows, int *cols);
+void stampPattern(PatternLibrary *library, Pattern *pattern, int orientation, BitGrid *grid, int row, int col);
+int placePattern(PatternLibrary *library, const Placement *placement, BitGrid *grid);
+
+#endif
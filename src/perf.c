@@ -0,0 +1,312 @@
+/*
+    Description:
+        Hardware counters of the stepping engine (see perf.h).
+
+    Sources:
+        https://man7.org/linux/man-pages/man2/perf_event_open.2.html
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "perf.h"
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef enum PerfEvent{
+    EVENT_CYCLES,
+    EVENT_INSTRUCTIONS,
+    EVENT_LLC_MISSES,
+    EVENT_BRANCHES,
+    EVENT_BRANCH_MISSES,
+    PERF_EVENTS
+} PerfEvent;
+
+typedef struct PerfThread{
+    int leader;                         // File descriptor of the group, -1 when this thread has no counters
+    int slots;                          // Number of counters opened in the group
+    int fds[PERF_EVENTS];               // File descriptor of every slot, the leader first
+    int slotEvent[PERF_EVENTS];         // Event counted by every slot of the group
+    unsigned long long begin[PERF_PHASES][PERF_EVENTS];
+    atomic_ullong total[PERF_PHASES][PERF_EVENTS]; // Written by the thread only, merged at any time
+    struct PerfThread *next;
+} PerfThread;
+
+static const char *phaseNames[PERF_PHASES] = {"pack", "compute"};
+
+static int enabled = 0;
+static int available[PERF_EVENTS]; // Events the group of the first thread could open
+static char error[128] = "not initialised";
+static _Thread_local PerfThread *local = NULL;
+static PerfThread *threads = NULL;  // Threads alive with their counters
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long retired[PERF_PHASES][PERF_EVENTS]; // Totals of the threads that ended, under threadsLock
+static unsigned long long previous[PERF_PHASES][PERF_EVENTS];
+static unsigned long long last[PERF_PHASES][PERF_EVENTS]; // Values of the last generation
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Counters ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+#ifdef __linux__
+
+static const unsigned long long eventConfigs[PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, // Last level cache misses
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int openEvent(PerfEvent event, int group){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = eventConfigs[event];
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0); // Calling thread, any CPU
+}
+
+static pthread_key_t threadKey; // Closes the group of a thread when it ends (jump threads, restarted workers)
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+
+// Destructor of threadKey: the totals of the thread are kept in retired, its counters are closed
+static void closeThread(void *arg){
+    PerfThread *thread = arg;
+    pthread_mutex_lock(&threadsLock);
+    for(PerfThread **link = &threads; *link != NULL; link = &(*link)->next){
+        if(*link == thread){
+            *link = thread->next;
+            break;
+        }
+    }
+    for(int p = 0; p < PERF_PHASES; ++p){
+        for(int e = 0; e < PERF_EVENTS; ++e){
+            retired[p][e] += atomic_load_explicit(&thread->total[p][e], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&threadsLock);
+    for(int s = 0; s < thread->slots; ++s){
+        close(thread->fds[s]);
+    }
+    free(thread);
+}
+
+static void createThreadKey(){
+    if(pthread_key_create(&threadKey, closeThread) != 0){
+        printf("\nERROR: createThreadKey() function => pthread_key_create failed\n");
+        exit(1);
+    }
+}
+
+// Open the group of the calling thread, the counters run from now on and are read at every phase boundary.
+// They are closed when the thread ends.
+static PerfThread *openThread(){
+    pthread_once(&threadKeyOnce, createThreadKey);
+    PerfThread *thread = calloc(1, sizeof(*thread));
+    if(thread == NULL){
+        printf("\nERROR: openThread() function => not enough memory\n");
+        exit(1);
+    }
+    thread->leader = -1;
+
+    for(int e = 0; e < PERF_EVENTS; ++e){
+        int fd = openEvent(e, thread->leader);
+        if(fd < 0){
+            if(thread->leader < 0){
+                snprintf(error, sizeof(error), "perf_event_open: %s", strerror(errno));
+                break; // Without cycles there is no group
+            }
+            continue; // This CPU doesn't count this event
+        }
+        if(thread->leader < 0){
+            thread->leader = fd;
+        }
+        thread->fds[thread->slots] = fd;
+        thread->slotEvent[thread->slots++] = e;
+    }
+
+    pthread_mutex_lock(&threadsLock);
+    thread->next = threads;
+    threads = thread;
+    pthread_mutex_unlock(&threadsLock);
+    pthread_setspecific(threadKey, thread);
+    return thread;
+}
+
+// Return 1 on success, 0 if the group couldn't be read
+static int readThread(PerfThread *thread, unsigned long long values[PERF_EVENTS]){
+    unsigned long long buffer[3 + PERF_EVENTS]; // nr, time enabled, time running, values
+    if(read(thread->leader, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(unsigned long long))){
+        return 0;
+    }
+    double scale = buffer[2] > 0 ? (double)buffer[1] / (double)buffer[2] : 1.0; // The counters were multiplexed
+    for(unsigned long long s = 0; s < buffer[0] && s < (unsigned long long)thread->slots; ++s){
+        values[thread->slotEvent[s]] = (unsigned long long)((double)buffer[3 + s] * scale);
+    }
+    return 1;
+}
+
+int perfInit(){
+    local = openThread();
+    if(local->leader < 0){
+        return 0;
+    }
+    for(int s = 0; s < local->slots; ++s){
+        available[local->slotEvent[s]] = 1;
+    }
+    enabled = 1;
+    return 1;
+}
+
+#else
+
+static PerfThread *openThread(){
+    return NULL;
+}
+
+static int readThread(PerfThread *thread, unsigned long long values[PERF_EVENTS]){
+    (void)thread;
+    (void)values;
+    return 0;
+}
+
+int perfInit(){
+    snprintf(error, sizeof(error), "hardware counters need Linux perf_event_open()");
+    return 0;
+}
+
+#endif
+
+const char *perfError(){
+    return error;
+}
+
+int perfEnabled(){
+    return enabled;
+}
+
+void perfStart(PerfPhase phase){
+    if(!enabled){
+        return;
+    }
+    if(local == NULL){
+        local = openThread(); // First phase of a worker
+    }
+    if(local->leader >= 0){
+        readThread(local, local->begin[phase]);
+    }
+}
+
+void perfStop(PerfPhase phase){
+    if(!enabled || local == NULL || local->leader < 0){
+        return;
+    }
+    unsigned long long end[PERF_EVENTS] = {0};
+    if(!readThread(local, end)){
+        return;
+    }
+    for(int e = 0; e < PERF_EVENTS; ++e){
+        // A single writer: a relaxed load and store, no locked instruction
+        atomic_ullong *total = &local->total[phase][e];
+        atomic_store_explicit(total, atomic_load_explicit(total, memory_order_relaxed) + end[e] - local->begin[phase][e],
+                              memory_order_relaxed);
+    }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Reports ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// From any thread, while the others count: a total may miss the phase being closed
+static void mergeThreads(unsigned long long totals[PERF_PHASES][PERF_EVENTS]){
+    pthread_mutex_lock(&threadsLock);
+    memcpy(totals, retired, sizeof(retired));
+    for(PerfThread *thread = threads; thread != NULL; thread = thread->next){
+        for(int p = 0; p < PERF_PHASES; ++p){
+            for(int e = 0; e < PERF_EVENTS; ++e){
+                totals[p][e] += atomic_load_explicit(&thread->total[p][e], memory_order_relaxed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&threadsLock);
+}
+
+void perfEndGeneration(){
+    if(!enabled){
+        return;
+    }
+    unsigned long long totals[PERF_PHASES][PERF_EVENTS];
+    mergeThreads(totals);
+    for(int p = 0; p < PERF_PHASES; ++p){
+        for(int e = 0; e < PERF_EVENTS; ++e){
+            last[p][e] = totals[p][e] - previous[p][e];
+            previous[p][e] = totals[p][e];
+        }
+    }
+}
+
+// Forget what was counted so far, must be called when the workers are idle
+void perfReset(){
+    pthread_mutex_lock(&threadsLock);
+    for(PerfThread *thread = threads; thread != NULL; thread = thread->next){
+        for(int p = 0; p < PERF_PHASES; ++p){
+            for(int e = 0; e < PERF_EVENTS; ++e){
+                atomic_store_explicit(&thread->total[p][e], 0, memory_order_relaxed);
+            }
+        }
+    }
+    memset(retired, 0, sizeof(retired));
+    pthread_mutex_unlock(&threadsLock);
+    memset(previous, 0, sizeof(previous));
+    memset(last, 0, sizeof(last));
+}
+
+static double ratio(unsigned long long a, unsigned long long b){
+    return b > 0 ? (double)a / (double)b : 0.0;
+}
+
+// IPC, LLC misses and branch-miss rate of the last generation, all phases together
+void perfStatus(char *text, int size){
+    if(!enabled){
+        snprintf(text, size, "no counters");
+        return;
+    }
+    unsigned long long sum[PERF_EVENTS] = {0};
+    for(int p = 0; p < PERF_PHASES; ++p){
+        for(int e = 0; e < PERF_EVENTS; ++e){
+            sum[e] += last[p][e];
+        }
+    }
+    snprintf(text, size, "IPC %.2f LLC %llu br %.1f%%", ratio(sum[EVENT_INSTRUCTIONS], sum[EVENT_CYCLES]),
+             sum[EVENT_LLC_MISSES], 100.0 * ratio(sum[EVENT_BRANCH_MISSES], sum[EVENT_BRANCHES]));
+}
+
+void perfReport(unsigned long long generations){
+    if(!enabled){
+        printf("hardware counters unavailable (%s)\n", error);
+        return;
+    }
+    unsigned long long totals[PERF_PHASES][PERF_EVENTS];
+    mergeThreads(totals);
+    double perGeneration = generations > 0 ? (double)generations : 1.0;
+
+    printf("%-8s %14s %14s %6s %14s %10s\n", "phase", "cycles/gen", "instr/gen", "IPC", "LLC miss/gen", "br miss");
+    for(int p = 0; p < PERF_PHASES; ++p){
+        char llc[32] = "n/a", branches[32] = "n/a";
+        if(available[EVENT_LLC_MISSES]){
+            snprintf(llc, sizeof(llc), "%.1f", totals[p][EVENT_LLC_MISSES] / perGeneration);
+        }
+        if(available[EVENT_BRANCHES] && available[EVENT_BRANCH_MISSES]){
+            snprintf(branches, sizeof(branches), "%.2f%%", 100.0 * ratio(totals[p][EVENT_BRANCH_MISSES], totals[p][EVENT_BRANCHES]));
+        }
+        printf("%-8s %14.0f %14.0f %6.2f %14s %10s\n", phaseNames[p], totals[p][EVENT_CYCLES] / perGeneration,
+               totals[p][EVENT_INSTRUCTIONS] / perGeneration, ratio(totals[p][EVENT_INSTRUCTIONS], totals[p][EVENT_CYCLES]),
+               llc, branches);
+    }
+}
@@ -0,0 +1,33 @@
+/*
+    Description:
+        Hardware counters of the stepping engine through Linux perf_event_open(). Once perfInit() succeeded, every
+        thread that calls perfStart() / perfStop() opens its own group of counters (cycles, instructions, last
+        level cache misses, branches, branch misses) and accumulates them per engine phase:
+            - PERF_PACK:    the lookup-table kernels packing their rows one bit per cell, the bit-plane kernel
+                            packing and unpacking its planes.
+            - PERF_COMPUTE: the computation of the next generation.
+        When the counters are not available (other OS, perf_event_paranoid, virtual machine without PMU, ...)
+        perfInit() returns 0 with the reason in perfError() and every other function does nothing. A counter
+        the CPU doesn't have is reported as n/a, the others still work.
+*/
+
+#ifndef PERF_H
+#define PERF_H
+
+typedef enum PerfPhase{
+    PERF_PACK,
+    PERF_COMPUTE,
+    PERF_PHASES
+} PerfPhase;
+
+int perfInit();
+const char *perfError();
+int perfEnabled();
+void perfStart(PerfPhase phase);
+void perfStop(PerfPhase phase);
+void perfEndGeneration();
+void perfReset();
+void perfStatus(char *text, int size);
+void perfReport(unsigned long long generations);
+
+#endif
@@ -0,0 +1,161 @@
+/*
+    Description:
+        Hot-path instrumentation (see prof.h).
+
+    Sources:
+        https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/ia-32-ia-64-benchmark-code-execution-paper.pdf
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "prof.h"
+
+#define CALIBRATION_NS 20000000ll // 20 ms to measure the TSC frequency
+
+// Written by their thread only, merged at any time
+typedef struct ProfThread{
+    atomic_ullong time[PHASE_COUNT];
+    atomic_ullong calls[PHASE_COUNT];
+    atomic_ullong count[COUNTER_COUNT];
+    struct ProfThread *next;
+} ProfThread;
+
+typedef struct ProfTotals{
+    unsigned long long time[PHASE_COUNT];
+    unsigned long long calls[PHASE_COUNT];
+    unsigned long long count[COUNTER_COUNT];
+} ProfTotals;
+
+static const char *phaseNames[PHASE_COUNT] = {"updateMap", "drawMap", "drawBorder", "refresh", "sleep", "input"};
+static const char *counterNames[COUNTER_COUNT] = {"births", "deaths", "cells touched"};
+
+static _Thread_local ProfThread *local = NULL; // Counters of the calling thread
+static ProfThread *threads = NULL;              // Counters of every thread, merged on demand
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static double ticksPerSecond = 1e9;
+static unsigned long long generations = 0;
+static ProfTotals previous; // Totals at the end of the previous generation
+static ProfTotals last;     // Values of the last generation
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Counters ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static long long nanoseconds(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000ll + now.tv_nsec;
+}
+
+// Measure the frequency of profNow()
+void profInit(){
+    long long startNs = nanoseconds();
+    unsigned long long startTicks = profNow();
+    long long elapsed;
+    do{
+        elapsed = nanoseconds() - startNs;
+    } while(elapsed < CALIBRATION_NS);
+    ticksPerSecond = (double)(profNow() - startTicks) * 1e9 / (double)elapsed;
+}
+
+// A single writer: a relaxed load and store, no locked instruction on the hot path
+static inline void addRelaxed(atomic_ullong *counter, unsigned long long n){
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static inline unsigned long long loadRelaxed(atomic_ullong *counter){
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static ProfThread *localCounters(){
+    if(local == NULL){
+        local = calloc(1, sizeof(*local));
+        if(local == NULL){
+            printf("\nERROR: localCounters() function => not enough memory\n");
+            exit(1);
+        }
+        pthread_mutex_lock(&threadsLock);
+        local->next = threads;
+        threads = local;
+        pthread_mutex_unlock(&threadsLock);
+    }
+    return local;
+}
+
+void profAddTime(ProfPhase phase, unsigned long long ticks){
+    ProfThread *counters = localCounters();
+    addRelaxed(&counters->time[phase], ticks);
+    addRelaxed(&counters->calls[phase], 1);
+}
+
+void profAddCount(ProfCounter counter, unsigned long long n){
+    addRelaxed(&localCounters()->count[counter], n);
+}
+
+// From any thread, while the others count
+static void mergeThreads(ProfTotals *totals){
+    *totals = (ProfTotals){{0}, {0}, {0}};
+    pthread_mutex_lock(&threadsLock);
+    for(ProfThread *thread = threads; thread != NULL; thread = thread->next){
+        for(int p = 0; p < PHASE_COUNT; ++p){
+            totals->time[p] += loadRelaxed(&thread->time[p]);
+            totals->calls[p] += loadRelaxed(&thread->calls[p]);
+        }
+        for(int c = 0; c < COUNTER_COUNT; ++c){
+            totals->count[c] += loadRelaxed(&thread->count[c]);
+        }
+    }
+    pthread_mutex_unlock(&threadsLock);
+}
+
+void profEndGeneration(){
+    ProfTotals totals;
+    mergeThreads(&totals);
+    for(int p = 0; p < PHASE_COUNT; ++p){
+        last.time[p] = totals.time[p] - previous.time[p];
+        last.calls[p] = totals.calls[p] - previous.calls[p];
+    }
+    for(int c = 0; c < COUNTER_COUNT; ++c){
+        last.count[c] = totals.count[c] - previous.count[c];
+    }
+    previous = totals;
+    generations++;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Reports ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static double microseconds(unsigned long long ticks){
+    return (double)ticks * 1e6 / ticksPerSecond;
+}
+
+// One line describing the last generation, short enough for the status line
+void profStatus(char *text, int size){
+    snprintf(text, size, "upd %.0f drw %.0f ref %.0f us +%llu -%llu",
+             microseconds(last.time[PHASE_UPDATE]),
+             microseconds(last.time[PHASE_DRAW_MAP] + last.time[PHASE_DRAW_BORDER]),
+             microseconds(last.time[PHASE_REFRESH]),
+             last.count[COUNTER_BIRTHS], last.count[COUNTER_DEATHS]);
+}
+
+void profReport(){
+    ProfTotals totals;
+    mergeThreads(&totals);
+    unsigned long long perGeneration = generations > 0 ? generations : 1;
+    unsigned long long all = 0;
+    for(int p = 0; p < PHASE_COUNT; ++p){
+        all += totals.time[p];
+    }
+
+    printf("%llu generations, TSC at %.0f MHz\n", generations, ticksPerSecond / 1e6);
+    printf("%-14s %12s %14s %8s\n", "phase", "total ms", "us/generation", "share");
+    for(int p = 0; p < PHASE_COUNT; ++p){
+        printf("%-14s %12.3f %14.2f %7.1f%%\n", phaseNames[p], microseconds(totals.time[p]) / 1e3,
+               microseconds(totals.time[p]) / perGeneration, all > 0 ? 100.0 * totals.time[p] / all : 0.0);
+    }
+    printf("%-14s %12s %14s\n", "counter", "total", "per generation");
+    for(int c = 0; c < COUNTER_COUNT; ++c){
+        printf("%-14s %12llu %14.1f\n", counterNames[c], totals.count[c], (double)totals.count[c] / perGeneration);
+    }
+}
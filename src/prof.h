@@ -0,0 +1,70 @@
+/*
+    Description:
+        Hot-path instrumentation. Compiled only with -DPROFILE, otherwise every macro is empty and costs nothing.
+            - PROF_START(phase) / PROF_STOP(phase): time a phase of the main loop with the TSC (clock_gettime()
+              elsewhere than x86), in the same block.
+            - PROF_COUNT(counter, n): add n to a counter (births, deaths, cells touched).
+            - PROF_GENERATION(): close a generation, its values are shown by profStatus().
+        Every thread accumulates in its own counters, they are only merged by PROF_GENERATION() and profReport().
+        The counters are relaxed atomics with a single writer, so a merge may run while other threads count
+        (the interactive program draws while a jump steps).
+*/
+
+#ifndef PROF_H
+#define PROF_H
+
+typedef enum ProfPhase{
+    PHASE_UPDATE,
+    PHASE_DRAW_MAP,
+    PHASE_DRAW_BORDER,
+    PHASE_REFRESH,
+    PHASE_SLEEP,
+    PHASE_INPUT,
+    PHASE_COUNT
+} ProfPhase;
+
+typedef enum ProfCounter{
+    COUNTER_BIRTHS,
+    COUNTER_DEATHS,
+    COUNTER_CELLS, // Cells computed by the kernels
+    COUNTER_COUNT
+} ProfCounter;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline unsigned long long profNow(){
+    return __rdtsc();
+}
+#else
+#include <time.h>
+static inline unsigned long long profNow(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+#endif
+
+void profInit();
+void profAddTime(ProfPhase phase, unsigned long long ticks);
+void profAddCount(ProfCounter counter, unsigned long long n);
+void profEndGeneration();
+void profStatus(char *text, int size);
+void profReport();
+
+#ifdef PROFILE
+
+#define PROF_START(phase) unsigned long long profStart##phase = profNow()
+#define PROF_STOP(phase) profAddTime(phase, profNow() - profStart##phase)
+#define PROF_COUNT(counter, n) profAddCount(counter, n)
+#define PROF_GENERATION() profEndGeneration()
+
+#else
+
+#define PROF_START(phase) ((void)0)
+#define PROF_STOP(phase) ((void)0)
+#define PROF_COUNT(counter, n) ((void)(n)) // Keeps the locals feeding a counter used, the compiler drops them
+#define PROF_GENERATION() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+/*
+    Description:
+        Lock-free publication of generations to reader threads (see publish.h).
+*/
+
+#include "publish.h"
+
+// Frames of rows x cols cells with that layout and topology, cleared by the workers of pool, nothing published yet
+void initPublisher(Publisher *publisher, int rows, int cols, GridLayout layout, Topology topology, WorkerPool *pool){
+    publisher->rows = rows;
+    publisher->cols = cols;
+    publisher->layout = layout;
+    publisher->topology = topology;
+    publisher->pool = pool;
+    initArena(&publisher->arena, "frames", 0);
+    publisher->frames = NULL;
+    atomic_init(&publisher->published, NULL);
+    atomic_init(&publisher->epoch, 1);
+    for(int r = 0; r < PUBLISH_READERS; ++r){
+        atomic_init(&publisher->readers[r].used, 0);
+        atomic_init(&publisher->readers[r].epoch, 0);
+        atomic_init(&publisher->readers[r].frame, NULL);
+    }
+}
+
+// Every reader must have been released
+void freePublisher(Publisher *publisher){
+    freeArena(&publisher->arena);
+    publisher->frames = NULL;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Writer ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// 1 if a reader holds frame or may be loading it
+static int frameHeld(Publisher *publisher, const Frame *frame){
+    for(int r = 0; r < PUBLISH_READERS; ++r){
+        Reader *reader = &publisher->readers[r];
+        unsigned long long epoch = atomic_load(&reader->epoch); // Before the frame, see publish.h
+        if(epoch != 0 && epoch <= frame->retired){
+            return 1;
+        }
+        if(atomic_load(&reader->frame) == frame){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// A frame for the writer only until it is published, its content is undefined. Never waits for the readers.
+Frame *takeFrame(Publisher *publisher){
+    Frame *published = atomic_load(&publisher->published);
+    Frame *frame;
+    for(frame = publisher->frames; frame != NULL; frame = frame->next){
+        if(frame != published && !frame->writing && !frameHeld(publisher, frame)){
+            break;
+        }
+    }
+    if(frame == NULL){
+        frame = arenaAlloc(&publisher->arena, sizeof(Frame), CACHE_LINE);
+        createGrid(&frame->map, publisher->rows, publisher->cols, publisher->layout, &publisher->arena, publisher->pool);
+        frame->map.topology = publisher->topology;
+        createTileCounts(&frame->tiles, publisher->rows, publisher->cols, &publisher->arena);
+        frame->generation = 0;
+        frame->retired = 0;
+        frame->next = publisher->frames;
+        publisher->frames = frame;
+    }
+    frame->writing = 1;
+    return frame;
+}
+
+// Hand a frame taken by takeFrame() to the readers, the previous one is retired
+void publishFrame(Publisher *publisher, Frame *frame){
+    frame->writing = 0;
+    Frame *previous = atomic_exchange(&publisher->published, frame);
+    unsigned long long epoch = atomic_fetch_add(&publisher->epoch, 1);
+    if(previous != NULL){
+        previous->retired = epoch;
+    }
+}
+
+// Last frame published, for the writer: it can read it but not write it
+Frame *publishedFrame(const Publisher *publisher){
+    return atomic_load(&((Publisher *)publisher)->published);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Readers ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Hold the last published frame, from any thread, until releaseReader(). NULL if nothing was published yet or
+// PUBLISH_READERS frames are already held.
+Reader *readFrame(Publisher *publisher){
+    Reader *reader = NULL;
+    for(int r = 0; r < PUBLISH_READERS && reader == NULL; ++r){
+        int free = 0;
+        if(atomic_compare_exchange_strong(&publisher->readers[r].used, &free, 1)){
+            reader = &publisher->readers[r];
+        }
+    }
+    if(reader == NULL){
+        return NULL;
+    }
+
+    atomic_store(&reader->epoch, atomic_load(&publisher->epoch));
+    Frame *frame = atomic_load(&publisher->published);
+    atomic_store(&reader->frame, frame);
+    atomic_store(&reader->epoch, 0);
+    if(frame == NULL){
+        releaseReader(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+void releaseReader(Reader *reader){
+    atomic_store(&reader->frame, NULL);
+    atomic_store(&reader->used, 0);
+}
@@ -0,0 +1,77 @@
+/*
+    Description:
+        Publication of the generations computed by one writer (the engine) to any number of reader threads (the
+        renderer, the exporters, the queries of life.h) without locks. The writer computes every generation in a
+        frame no reader can reach (takeFrame()), then publishes it with a single atomic store (publishFrame()); a
+        published frame is never written again until it is reclaimed. A reader holds the frame it read until
+        releaseReader(), so it always sees a whole generation, and the writer never waits for it: when every frame
+        is published or held, takeFrame() allocates another one.
+
+        Reclamation is epoch-based. The publisher's epoch is incremented at every publication and a frame that
+        stops being the published one is retired with the epoch it was published until. A reader announces the
+        epoch in its slot before it loads the published frame, then records that frame in its slot and clears the
+        epoch. A retired frame is reused once no slot records it and no slot announces an epoch up to its
+        retirement, since a reader that announced a later epoch loaded the published frame after this one was
+        replaced. The writer reads a slot's epoch before its frame, the reader writes them in the other order.
+
+        Every frame carries the alive cells of its tiles (see TileCounts in grid.h), counted by the engine when
+        the writer passes them to trackTiles().
+
+    Sources:
+        https://en.wikipedia.org/wiki/Read-copy-update
+        https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf (Fraser, Practical lock-freedom, epoch-based reclamation)
+*/
+
+#ifndef PUBLISH_H
+#define PUBLISH_H
+
+#include <stdatomic.h>
+#include "grid.h"
+
+#define PUBLISH_READERS 64 // Frames held at once by the readers
+
+typedef struct Frame{
+    Grid map;
+    TileCounts tiles;
+    long long generation;
+    unsigned long long retired; // Epoch at which the frame stopped being published, 0 if it never was
+    int writing;                // Taken by the writer and not published yet
+    struct Frame *next;         // Every frame of the publisher
+} Frame;
+
+typedef struct Reader{
+    atomic_int used;
+    atomic_ullong epoch;        // Epoch announced while the published frame is read, 0 otherwise
+    _Atomic(Frame *) frame;     // Frame held, NULL if none
+} Reader;
+
+typedef struct Publisher{
+    int rows;
+    int cols;
+    GridLayout layout;
+    Topology topology;
+    WorkerPool *pool;           // Workers that first touch the frames, those of the writer's engine
+    Arena arena;                // Frames, kept until freePublisher()
+    Frame *frames;              // Only walked by the writer
+    _Atomic(Frame *) published;
+    atomic_ullong epoch;        // From 1, incremented at every publication
+    Reader readers[PUBLISH_READERS];
+} Publisher;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+void initPublisher(Publisher *publisher, int rows, int cols, GridLayout layout, Topology topology, WorkerPool *pool);
+void freePublisher(Publisher *publisher);
+Frame *takeFrame(Publisher *publisher);
+void publishFrame(Publisher *publisher, Frame *frame);
+Frame *publishedFrame(const Publisher *publisher);
+Reader *readFrame(Publisher *publisher);
+void releaseReader(Reader *reader);
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Accessors ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+// Frame held by a reader returned by readFrame()
+static inline const Frame *readerFrame(const Reader *reader){
+    return atomic_load(&((Reader *)reader)->frame);
+}
+
+#endif
@@ -0,0 +1,411 @@
+/*
+    Description:
+        Output of the interactive program, independent of the terminal library (see render.h).
+
+    Sources:
+        https://invisible-island.net/ncurses/man/curs_add_wch.3x.html (alternate character set)
+        https://en.wikipedia.org/wiki/ANSI_escape_code
+        https://en.wikipedia.org/wiki/Box-drawing_characters
+        https://en.wikipedia.org/wiki/Braille_Patterns#Identifying,_naming_and_ordering
+*/
+
+#include <locale.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef NO_CURSES
+#include <curses.h>
+#endif
+#ifndef _WIN32
+#include <termios.h>
+#include <unistd.h>
+#endif
+#include "render.h"
+
+#define TEXT_SIZE 256
+#define CELL_BYTES 4 // A UTF-8 character of at most 3 bytes and its terminating 0
+#define HALF_BLOCKS 0x2580 // Upper half block, the lower and full blocks are at +4 and +8
+#define BRAILLE 0x2800     // Braille pattern without dots
+
+typedef struct ScreenCell{
+    char text[CELL_BYTES];
+} ScreenCell;
+
+static Backend backend = DEFAULT_BACKEND;
+static int screenRows = 0;
+static int screenCols = 0;
+
+// ANSI backend: cells drawn in this frame, cells on the terminal, and the bytes of the next write(), from screenArena
+static Arena *screenArena = NULL;
+static ArenaMark screenMark; // Where screenArena is rewound by endRenderer()
+static ScreenCell *back = NULL;
+static ScreenCell *front = NULL;
+static char *output = NULL;
+static size_t outputSize = 0;
+#ifndef _WIN32
+static struct termios savedTermios;
+#endif
+
+static const char *utf8Glyphs[GLYPH_COUNT] = {" ", "\xC2\xB0", "\xC2\xB7", "\xE2\x96\xB2", "\xE2\x96\xBC", // " ° · ▲ ▼"
+                                              "\xE2\x95\x90", "\xE2\x95\x91", "\xE2\x95\x94", "\xE2\x95\x97", // "═ ║ ╔ ╗"
+                                              "\xE2\x95\x9A", "\xE2\x95\x9D"};                              // "╚ ╝"
+
+// Read a backend name ("curses", "ansi" or "null"). Return 1 on success, 0 otherwise.
+int parseBackend(const char *text, Backend *parsed){
+#ifndef NO_CURSES
+    if(strcmp(text, "curses") == 0){
+        *parsed = BACKEND_CURSES;
+        return 1;
+    }
+#endif
+#ifndef _WIN32
+    if(strcmp(text, "ansi") == 0){
+        *parsed = BACKEND_ANSI;
+        return 1;
+    }
+    if(strcmp(text, "null") == 0){
+        *parsed = BACKEND_NULL;
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+// Read a view name ("cells", "half" or "braille"). Return 1 on success, 0 otherwise.
+int parseView(const char *text, View *view){
+    if(strcmp(text, "cells") == 0){
+        *view = VIEW_CELLS;
+    }
+    else if(strcmp(text, "half") == 0){
+        *view = VIEW_HALF;
+    }
+    else if(strcmp(text, "braille") == 0){
+        *view = VIEW_BRAILLE;
+    }
+    else{
+        return 0;
+    }
+    return 1;
+}
+
+// Characters taken by a map of rows x cols cells, VIEW_CELLS counted as one character per cell
+void viewSize(View view, int rows, int cols, int *viewRows, int *viewCols){
+    *viewRows = view == VIEW_HALF ? (rows + 1) / 2 : view == VIEW_BRAILLE ? (rows + 3) / 4 : rows;
+    *viewCols = view == VIEW_BRAILLE ? (cols + 1) / 2 : cols;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ ANSI backend ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+static void append(const char *bytes, size_t size){
+    memcpy(output + outputSize, bytes, size);
+    outputSize += size;
+}
+
+static void flushOutput(){
+#ifndef _WIN32
+    for(size_t written = 0; written < outputSize;){
+        ssize_t n = write(STDOUT_FILENO, output + written, outputSize - written);
+        if(n <= 0){
+            break;
+        }
+        written += (size_t)n;
+    }
+#endif
+    outputSize = 0;
+}
+
+static void initAnsi(){
+    size_t cells = (size_t)screenRows * screenCols;
+    screenMark = arenaMark(screenArena);
+    back = arenaAlloc(screenArena, cells * sizeof(ScreenCell), CACHE_LINE);
+    front = arenaAlloc(screenArena, cells * sizeof(ScreenCell), CACHE_LINE);
+    // Every cell changed and preceded by a cursor move
+    output = arenaAlloc(screenArena, cells * (CELL_BYTES + 12) + TEXT_SIZE, CACHE_LINE);
+    for(size_t k = 0; k < cells; ++k){
+        strcpy(back[k].text, " ");
+        strcpy(front[k].text, " ");
+    }
+
+#ifndef _WIN32
+    // Keys are read one at a time without echo, Enter still arrives as '\n'
+    struct termios raw;
+    tcgetattr(STDIN_FILENO, &savedTermios);
+    raw = savedTermios;
+    raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+#endif
+
+    // Alternate screen, hidden cursor, cleared screen, and the size of the window if the terminal allows it
+    char text[TEXT_SIZE];
+    int size = snprintf(text, sizeof(text), "\x1B[?1049h\x1B[?25l\x1B[2J\x1B[8;%d;%dt", screenRows, screenCols);
+    append(text, (size_t)size);
+    flushOutput();
+}
+
+static void endAnsi(){
+    append("\x1B[?25h\x1B[?1049l", 14);
+    flushOutput();
+#ifndef _WIN32
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedTermios);
+#endif
+    arenaRelease(screenArena, screenMark);
+    back = front = NULL;
+    output = NULL;
+}
+
+static void putCell(int row, int col, const char *text, size_t size){
+    if(row < 0 || row >= screenRows || col < 0 || col >= screenCols || size >= CELL_BYTES){
+        return;
+    }
+    ScreenCell *cell = &back[(size_t)row * screenCols + col];
+    memcpy(cell->text, text, size);
+    cell->text[size] = '\0';
+}
+
+// Only the runs of changed cells are written, a cursor move before every run
+static void presentAnsi(){
+    int cursorRow = -1, cursorCol = -1;
+    for(int i = 0; i < screenRows; ++i){
+        for(int j = 0; j < screenCols; ++j){
+            size_t k = (size_t)i * screenCols + j;
+            if(strcmp(back[k].text, front[k].text) == 0){
+                continue;
+            }
+            if(i != cursorRow || j != cursorCol){
+                char move[16];
+                int size = snprintf(move, sizeof(move), "\x1B[%d;%dH", i + 1, j + 1);
+                append(move, (size_t)size);
+            }
+            append(back[k].text, strlen(back[k].text));
+            front[k] = back[k];
+            cursorRow = i;
+            cursorCol = j + 1;
+        }
+    }
+    flushOutput();
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Renderer ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+#ifndef NO_CURSES
+static chtype cursesGlyph(Glyph glyph){
+    switch(glyph){
+        case GLYPH_ALIVE: return ACS_DEGREE;
+        case GLYPH_DYING: return ACS_BULLET;
+        case GLYPH_UP: return ACS_UARROW;
+        case GLYPH_DOWN: return ACS_DARROW;
+        case GLYPH_HORIZONTAL: return ACS_HLINE;
+        case GLYPH_VERTICAL: return ACS_VLINE;
+        case GLYPH_TOP_LEFT: return ACS_ULCORNER;
+        case GLYPH_TOP_RIGHT: return ACS_URCORNER;
+        case GLYPH_BOTTOM_LEFT: return ACS_LLCORNER;
+        case GLYPH_BOTTOM_RIGHT: return ACS_LRCORNER;
+        default: return ' ';
+    }
+}
+#endif
+
+// A screen of rows x cols characters, its buffers taken from arena until endRenderer()
+void initRenderer(Backend selected, int rows, int cols, Arena *arena){
+    backend = selected;
+    screenArena = arena;
+    screenRows = rows;
+    screenCols = cols;
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        setlocale(LC_ALL, ""); // UTF-8 half blocks and braille
+        initscr(); // Init the screen
+        curs_set(0); // Hide the cursor
+        resize_term(rows, cols); // Resize the terminal
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        initAnsi();
+    }
+}
+
+void endRenderer(){
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        endwin();
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        endAnsi();
+    }
+}
+
+Backend rendererBackend(){
+    return backend;
+}
+
+void clearScreen(){
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        clear();
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        for(size_t k = 0; k < (size_t)screenRows * screenCols; ++k){
+            strcpy(back[k].text, " ");
+        }
+    }
+}
+
+// Clear row from col to its end
+void clearLine(int row, int col){
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        move(row, col);
+        clrtoeol();
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        for(int j = col; j < screenCols; ++j){
+            putCell(row, j, " ", 1);
+        }
+    }
+}
+
+void drawGlyph(int row, int col, Glyph glyph){
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        mvaddch(row, col, cursesGlyph(glyph));
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        putCell(row, col, utf8Glyphs[glyph], strlen(utf8Glyphs[glyph]));
+    }
+}
+
+// printf() at (row, col), one character per cell, cut at the edge of the screen
+void drawText(int row, int col, const char *format, ...){
+    if(backend == BACKEND_NULL){
+        return;
+    }
+    char text[TEXT_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        mvaddstr(row, col, text);
+        return;
+    }
+#endif
+    for(int k = 0; text[k] != '\0'; ++k){
+        putCell(row, col + k, &text[k], 1);
+    }
+}
+
+static void drawCodepoint(int row, int col, unsigned codepoint){
+    char text[CELL_BYTES];
+    size_t size;
+    if(codepoint < 0x80){
+        text[0] = (char)codepoint;
+        size = 1;
+    }
+    else if(codepoint < 0x800){
+        text[0] = (char)(0xC0 | codepoint >> 6);
+        text[1] = (char)(0x80 | (codepoint & 0x3F));
+        size = 2;
+    }
+    else{
+        text[0] = (char)(0xE0 | codepoint >> 12);
+        text[1] = (char)(0x80 | (codepoint >> 6 & 0x3F));
+        text[2] = (char)(0x80 | (codepoint & 0x3F));
+        size = 3;
+    }
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        text[size] = '\0';
+        mvaddstr(row, col, text);
+        return;
+    }
+#endif
+    putCell(row, col, text, size);
+}
+
+// " ", upper half, lower half and full block for the 2 bits top | bottom << 1
+static unsigned halfBlock(unsigned bits){
+    static const unsigned blocks[4] = {' ', HALF_BLOCKS, HALF_BLOCKS + 4, HALF_BLOCKS + 8};
+    return blocks[bits];
+}
+
+// Spread the 32 bits of x on the even bits
+static unsigned long long spreadWord(unsigned long long x){
+    x &= 0xFFFFFFFFull;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2)) & 0x3333333333333333ull;
+    x = (x | (x << 1)) & 0x5555555555555555ull;
+    return x;
+}
+
+// The 2 rows of cells interleaved: column b on bits 2b (top) and 2b + 1 (bottom) of pairs[b / 32], so the half
+// block of a column is one shift and mask
+static void halfPairs(const unsigned long long rows[4], unsigned long long pairs[2]){
+    for(int half = 0; half < 2; ++half){
+        pairs[half] = spreadWord(rows[0] >> 32 * half) | spreadWord(rows[1] >> 32 * half) << 1;
+    }
+}
+
+// Dots of the braille character of columns shift and shift + 1 in 4 rows. The dots are numbered down the left
+// column (bits 0, 1, 2) then the right one (bits 3, 4, 5), the bottom row last (bits 6 left and 7 right):
+// the pair of cells of row k moves its left bit to k and its right bit to k + 3.
+static unsigned brailleDots(const unsigned long long rows[4], int shift){
+    unsigned dots = (unsigned)(rows[3] >> shift & 3) << 6;
+    for(int k = 0; k < 3; ++k){
+        unsigned pair = (unsigned)(rows[k] >> shift & 3);
+        dots |= (pair & 1) << k | (pair & 2) << (k + 2);
+    }
+    return dots;
+}
+
+// Alive cells of bits from (row, col) in VIEW_HALF or VIEW_BRAILLE, see viewSize() for the characters taken.
+// Rows past the last one are read as dead, like the bits past the last column. An empty braille character is
+// drawn as a space, a single byte.
+void drawPacked(int row, int col, const BitGrid *bits, View view){
+    if(backend == BACKEND_NULL){
+        return;
+    }
+    int height = view == VIEW_BRAILLE ? 4 : 2;
+    for(int i = 0; i < bits->rows; i += height){
+        for(int w = 0; w < bits->words; ++w){
+            unsigned long long rows[4] = {0, 0, 0, 0};
+            for(int k = 0; k < height && i + k < bits->rows; ++k){
+                rows[k] = bitRow(bits, i + k)[w];
+            }
+            int end = bits->cols - 64 * w < 64 ? bits->cols - 64 * w : 64;
+            if(view == VIEW_HALF){
+                unsigned long long pairs[2];
+                halfPairs(rows, pairs);
+                for(int b = 0; b < end; ++b){
+                    unsigned pair = (unsigned)(pairs[b / 32] >> 2 * (b % 32) & 3);
+                    drawCodepoint(row + i / 2, col + 64 * w + b, halfBlock(pair));
+                }
+            }
+            else{
+                for(int b = 0; b < end; b += 2){
+                    unsigned dots = brailleDots(rows, b);
+                    drawCodepoint(row + i / 4, col + (64 * w + b) / 2, dots != 0 ? BRAILLE + dots : ' ');
+                }
+            }
+        }
+    }
+}
+
+void presentFrame(){
+#ifndef NO_CURSES
+    if(backend == BACKEND_CURSES){
+        refresh();
+    }
+#endif
+    if(backend == BACKEND_ANSI){
+        presentAnsi();
+    }
+}
@@ -0,0 +1,87 @@
+/*
+    Description:
+        Output of the interactive program, independent of the terminal library. The program draws text and
+        glyphs at (row, col) and presents the frame once it is complete; a backend turns that into output:
+            - BACKEND_CURSES: the curses library (ncurses on Linux, PDCurses on Windows), glyphs from its
+                              alternate character set.
+            - BACKEND_ANSI:   no library, a copy of the screen is kept and presentFrame() writes only the cells
+                              that changed since the last frame, as UTF-8 and ANSI escape sequences, in a single
+                              write(). The keyboard is read raw from stdin (see input.c). POSIX only.
+            - BACKEND_NULL:   nothing is drawn, to time the simulation loop without any output (the generations
+                              reached and the time taken are printed on exit). Commands are read from stdin as
+                              keys, one character each; the number or pattern typed after 'n', 'g' or 'i' ends
+                              with a newline.
+        There is a single screen: the state of the renderer is global to the program. The buffers of the ANSI
+        backend come from the arena given to initRenderer(), endRenderer() rewinds it to where it was.
+
+        Compiled with -DNO_CURSES, the curses backend is left out and the program needs no library; the ANSI
+        backend is then the default.
+
+        The map is drawn a cell per character (VIEW_CELLS) or from its packed alive cells (see grid.h) with
+        drawPacked(), several cells per character:
+            - VIEW_HALF:    2 cells, one above the other, as a half block "▀", "▄", "█" or " ".
+            - VIEW_BRAILLE: 2 x 4 cells as the dots of a braille pattern (U+2800 + one bit per dot).
+        A character of either view is found from the bits of its rows by shifts and masks, without any test per
+        cell. The curses backend needs a wide-character curses (ncursesw) and a UTF-8 locale for these views.
+
+    Sources:
+        https://invisible-island.net/ncurses/man/ncurses.3x.html
+        https://en.wikipedia.org/wiki/ANSI_escape_code
+        https://en.wikipedia.org/wiki/Block_Elements
+        https://en.wikipedia.org/wiki/Braille_Patterns
+*/
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "arena.h"
+#include "grid.h"
+
+typedef enum Backend{
+    BACKEND_CURSES,
+    BACKEND_ANSI,
+    BACKEND_NULL
+} Backend;
+
+#ifdef NO_CURSES
+#define DEFAULT_BACKEND BACKEND_ANSI
+#else
+#define DEFAULT_BACKEND BACKEND_CURSES
+#endif
+
+typedef enum View{
+    VIEW_CELLS,
+    VIEW_HALF,
+    VIEW_BRAILLE
+} View;
+
+typedef enum Glyph{
+    GLYPH_DEAD,
+    GLYPH_ALIVE,
+    GLYPH_DYING,          // Dying cell of a Generations rule
+    GLYPH_UP,             // Alive triangle pointing up
+    GLYPH_DOWN,           // and down
+    GLYPH_HORIZONTAL,     // Border
+    GLYPH_VERTICAL,
+    GLYPH_TOP_LEFT,
+    GLYPH_TOP_RIGHT,
+    GLYPH_BOTTOM_LEFT,
+    GLYPH_BOTTOM_RIGHT,
+    GLYPH_COUNT
+} Glyph;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int parseBackend(const char *text, Backend *backend);
+int parseView(const char *text, View *view);
+void viewSize(View view, int rows, int cols, int *viewRows, int *viewCols);
+void initRenderer(Backend backend, int rows, int cols, Arena *arena);
+void endRenderer();
+Backend rendererBackend();
+void clearScreen();
+void clearLine(int row, int col);
+void drawGlyph(int row, int col, Glyph glyph);
+void drawText(int row, int col, const char *format, ...) __attribute__((format(printf, 3, 4)));
+void drawPacked(int row, int col, const BitGrid *bits, View view);
+void presentFrame();
+
+#endif
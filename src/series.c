@@ -0,0 +1,57 @@
+/*
+    Description:
+        Time series of the statistics of every generation (see series.h).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "series.h"
+
+// Open the file, CSV or binary from its extension. Return 1 on success, 0 otherwise.
+int openSeries(Series *series, const char *path, Arena *arena){
+    size_t length = strlen(path);
+    series->format = length >= 4 && strcmp(path + length - 4, ".bin") == 0 ? SERIES_BINARY : SERIES_CSV;
+    series->file = fopen(path, series->format == SERIES_BINARY ? "wb" : "w");
+    if(series->file == NULL){
+        return 0;
+    }
+    series->records = arenaAlloc(arena, SERIES_BUFFER * sizeof(SeriesRecord), CACHE_LINE);
+    series->count = 0;
+    if(series->format == SERIES_CSV){
+        fprintf(series->file, "generation,population,births,deaths,min_row,max_row,min_col,max_col\n");
+    }
+    return 1;
+}
+
+void addRecord(Series *series, long long generation, const StepStats *stats){
+    int empty = stats->minRow > stats->maxRow;
+    series->records[series->count++] = (SeriesRecord){
+        generation, (int64_t)stats->population, (int64_t)stats->births, (int64_t)stats->deaths,
+        empty ? -1 : stats->minRow, empty ? -1 : stats->maxRow, empty ? -1 : stats->minCol, empty ? -1 : stats->maxCol
+    };
+    if(series->count == SERIES_BUFFER){
+        flushSeries(series);
+    }
+}
+
+void flushSeries(Series *series){
+    if(series->format == SERIES_BINARY){
+        fwrite(series->records, sizeof(SeriesRecord), series->count, series->file);
+    }
+    else{
+        for(int k = 0; k < series->count; ++k){
+            const SeriesRecord *r = &series->records[k];
+            fprintf(series->file, "%lld,%lld,%lld,%lld,%d,%d,%d,%d\n", (long long)r->generation, (long long)r->population,
+                    (long long)r->births, (long long)r->deaths, r->minRow, r->maxRow, r->minCol, r->maxCol);
+        }
+    }
+    series->count = 0;
+}
+
+void closeSeries(Series *series){
+    if(series->file != NULL){
+        flushSeries(series);
+        fclose(series->file);
+        series->file = NULL;
+    }
+}
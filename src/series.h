@@ -0,0 +1,49 @@
+/*
+    Description:
+        Time series of the statistics of every generation (population, births, deaths, bounding box, see
+        StepStats in engine.h), written to a file for charts. Records are buffered SERIES_BUFFER at a time and
+        written in one go, so the step loop only copies a few words per generation.
+
+        Formats, chosen from the extension of the file:
+            - .csv (and anything else): a header line then "generation,population,births,deaths,min_row,max_row,
+              min_col,max_col" lines, the bounding box is empty (-1) when it isn't tracked.
+            - .bin: SeriesRecord structures back to back, in the byte order of the machine.
+*/
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "engine.h"
+
+#define SERIES_BUFFER 4096
+
+typedef enum SeriesFormat{
+    SERIES_CSV,
+    SERIES_BINARY
+} SeriesFormat;
+
+typedef struct SeriesRecord{
+    int64_t generation;
+    int64_t population;
+    int64_t births;
+    int64_t deaths;
+    int32_t minRow, maxRow; // -1 when empty
+    int32_t minCol, maxCol;
+} SeriesRecord;
+
+typedef struct Series{
+    FILE *file;
+    SeriesFormat format;
+    SeriesRecord *records;
+    int count;
+} Series;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int openSeries(Series *series, const char *path, Arena *arena);
+void addRecord(Series *series, long long generation, const StepStats *stats);
+void flushSeries(Series *series);
+void closeSeries(Series *series);
+
+#endif
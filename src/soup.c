@@ -0,0 +1,148 @@
+/*
+    Description:
+        Random initial conditions (see soup.h).
+
+    Sources:
+        https://prng.di.unimi.it/splitmix64.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "soup.h"
+#include "threads.h"
+
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15ull
+#define DENSITY_BITS 8 // The density is rounded to a multiple of 1 / 256
+
+typedef struct SoupTask{
+    const Soup *soup;
+    BitGrid *grid;
+    int threshold; // Alive with probability threshold / 256
+} SoupTask;
+
+// Read a symmetry name ("none", "c2", "c4", "d2" or "d4"). Return 1 on success, 0 otherwise.
+int parseSymmetry(const char *text, Symmetry *symmetry){
+    if(strcmp(text, "none") == 0){
+        *symmetry = SYMMETRY_NONE;
+    }
+    else if(strcmp(text, "c2") == 0){
+        *symmetry = SYMMETRY_C2;
+    }
+    else if(strcmp(text, "c4") == 0){
+        *symmetry = SYMMETRY_C4;
+    }
+    else if(strcmp(text, "d2") == 0){
+        *symmetry = SYMMETRY_D2;
+    }
+    else if(strcmp(text, "d4") == 0){
+        *symmetry = SYMMETRY_D4;
+    }
+    else{
+        return 0;
+    }
+    return 1;
+}
+
+// SplitMix64 output number counter, a pure function so any word can be drawn in any order
+static inline unsigned long long randomWord(unsigned long long seed, unsigned long long counter){
+    unsigned long long z = seed + (counter + 1) * GOLDEN_GAMMA;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// 64 cells alive with probability threshold / 256: from the lowest bit of the threshold up, a 1 bit ORs a random
+// word in (p = (p + 1) / 2) and a 0 bit ANDs it (p = p / 2), the bits below the lowest 1 would only AND zeros
+static unsigned long long soupWord(unsigned long long seed, unsigned long long index, int threshold){
+    if(threshold >= 1 << DENSITY_BITS){
+        return ~0ull;
+    }
+    unsigned long long word = 0;
+    unsigned long long counter = index * DENSITY_BITS;
+    for(int bit = threshold ? __builtin_ctz(threshold) : DENSITY_BITS; bit < DENSITY_BITS; ++bit){
+        unsigned long long r = randomWord(seed, counter + bit);
+        word = (threshold >> bit & 1) ? word | r : word & r;
+    }
+    return word;
+}
+
+// Cell that gives its value to the orbit of (i, j): the first one in row-major order
+static void orbitFirst(Symmetry symmetry, int rows, int cols, int *i, int *j){
+    int mirrorI = rows - 1 - *i, mirrorJ = cols - 1 - *j;
+    if(symmetry == SYMMETRY_C2){
+        if(mirrorI < *i || (mirrorI == *i && mirrorJ < *j)){
+            *i = mirrorI;
+            *j = mirrorJ;
+        }
+    }
+    else if(symmetry == SYMMETRY_C4){
+        // (i, j) -> (j, n - 1 - i) -> (n - 1 - i, n - 1 - j) -> (n - 1 - j, i)
+        int orbit[4][2] = {{*i, *j}, {*j, mirrorI}, {mirrorI, mirrorJ}, {mirrorJ, *i}};
+        for(int k = 1; k < 4; ++k){
+            if(orbit[k][0] < *i || (orbit[k][0] == *i && orbit[k][1] < *j)){
+                *i = orbit[k][0];
+                *j = orbit[k][1];
+            }
+        }
+    }
+    else{
+        if(mirrorJ < *j){
+            *j = mirrorJ;
+        }
+        if(symmetry == SYMMETRY_D4 && mirrorI < *i){
+            *i = mirrorI;
+        }
+    }
+}
+
+static void soupBand(int band, int startRow, int endRow, void *arg){
+    SoupTask *task = arg;
+    BitGrid *grid = task->grid;
+    unsigned long long seed = task->soup->seed;
+    Symmetry symmetry = task->soup->symmetry;
+    (void)band;
+
+    int tail = grid->cols & 63;
+    unsigned long long lastMask = tail ? (1ull << tail) - 1 : ~0ull;
+    for(int i = startRow; i < endRow; ++i){
+        unsigned long long *row = bitRow(grid, i);
+        if(symmetry == SYMMETRY_NONE){
+            for(int w = 0; w < grid->words; ++w){
+                row[w] = soupWord(seed, (unsigned long long)i * grid->words + w, task->threshold);
+            }
+        }
+        else{
+            // Every cell reads the word of its orbit's first cell, drawn again instead of read from another
+            // band, so the bands stay independent. Consecutive cells mostly share that word.
+            unsigned long long cachedIndex = ~0ull, cached = 0;
+            for(int w = 0; w < grid->words; ++w){
+                unsigned long long word = 0;
+                int end = grid->cols - 64 * w < 64 ? grid->cols - 64 * w : 64;
+                for(int b = 0; b < end; ++b){
+                    int firstI = i, firstJ = 64 * w + b;
+                    orbitFirst(symmetry, grid->rows, grid->cols, &firstI, &firstJ);
+                    unsigned long long index = (unsigned long long)firstI * grid->words + (firstJ >> 6);
+                    if(index != cachedIndex){
+                        cachedIndex = index;
+                        cached = soupWord(seed, index, task->threshold);
+                    }
+                    word |= (cached >> (firstJ & 63) & 1) << b;
+                }
+                row[w] = word;
+            }
+        }
+        row[grid->words - 1] &= lastMask;
+    }
+}
+
+// Overwrite every cell of the grid, the bands are filled by the workers
+void fillSoup(const Soup *soup, BitGrid *grid){
+    if(soup->symmetry == SYMMETRY_C4 && grid->rows != grid->cols){
+        printf("\nERROR: fillSoup() function => c4 symmetry needs a square grid, not %dx%d\n", grid->rows, grid->cols);
+        exit(1);
+    }
+    double density = soup->density < 0 ? 0 : (soup->density > 1 ? 1 : soup->density);
+    SoupTask task = {soup, grid, (int)(density * (1 << DENSITY_BITS) + 0.5)};
+    runWorkers(soupBand, grid->rows, &task);
+}
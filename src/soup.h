@@ -0,0 +1,49 @@
+/*
+    Description:
+        Random initial conditions ("soups") for benchmarks and searches. A soup is fully described by a 64-bit
+        seed, the density of alive cells and a symmetry, so the same three values always give the same board
+        whatever the number of threads.
+
+        The cells are drawn 64 at a time with a counter-based generator (SplitMix64 of the seed and the index of
+        the word): there is no state to carry from a word to the next one, so every band of rows is filled
+        independently by its worker. A density p is rounded to k / 256 and a word of cells of probability k / 256
+        is built from at most 8 random words, one per bit of k (a word with density 1/2 is a single call).
+
+        Symmetries (the orbit of a cell takes the value of its first cell in row-major order):
+            - SYMMETRY_NONE: every cell is drawn.
+            - SYMMETRY_C2:   invariant by a half turn.
+            - SYMMETRY_C4:   invariant by a quarter turn, square boards only.
+            - SYMMETRY_D2:   invariant by the left-right mirror.
+            - SYMMETRY_D4:   invariant by the left-right and the top-bottom mirrors.
+
+    Sources:
+        https://prng.di.unimi.it/splitmix64.c
+        https://conwaylife.com/wiki/Soup
+*/
+
+#ifndef SOUP_H
+#define SOUP_H
+
+#include "grid.h"
+
+#define SOUP_DENSITY 0.5
+
+typedef enum Symmetry{
+    SYMMETRY_NONE,
+    SYMMETRY_C2,
+    SYMMETRY_C4,
+    SYMMETRY_D2,
+    SYMMETRY_D4
+} Symmetry;
+
+typedef struct Soup{
+    unsigned long long seed;
+    double density;     // Probability of an alive cell, between 0 and 1
+    Symmetry symmetry;
+} Soup;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+int parseSymmetry(const char *text, Symmetry *symmetry);
+void fillSoup(const Soup *soup, BitGrid *grid);
+
+#endif
@@ -0,0 +1,180 @@
+/*
+    Description:
+        Pools of worker threads used by the multithreaded engine (see threads.h). The calling thread runs band 0
+        itself, workers 1 to count - 1 wait for the next task on a condition variable.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "grid.h"
+#include "threads.h"
+
+typedef struct WorkerSeat{
+    WorkerPool *pool;
+    int band;
+} WorkerSeat;
+
+static WorkerPool program = {.count = 1, .lock = PTHREAD_MUTEX_INITIALIZER, .busy = PTHREAD_MUTEX_INITIALIZER,
+                             .taskReady = PTHREAD_COND_INITIALIZER, .taskDone = PTHREAD_COND_INITIALIZER};
+
+static void runBand(WorkerPool *pool, int band){
+    int startRow, endRow;
+    workerBandRows(pool, band, pool->rows, &startRow, &endRow);
+    if(startRow < endRow){
+        pool->task(band, startRow, endRow, pool->arg);
+    }
+}
+
+static void *workerLoop(void *arg){
+    WorkerSeat *seat = arg;
+    WorkerPool *pool = seat->pool;
+    unsigned long seen = pool->firstTask;
+
+    pthread_mutex_lock(&pool->lock);
+    while(1){
+        while(!pool->stopping && pool->taskNumber == seen){
+            pthread_cond_wait(&pool->taskReady, &pool->lock);
+        }
+        if(pool->stopping){
+            break;
+        }
+        seen = pool->taskNumber;
+        pthread_mutex_unlock(&pool->lock);
+
+        runBand(pool, seat->band);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->pending == 0){
+            pthread_cond_signal(&pool->taskDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// A pool without threads, tasks run in the caller until startWorkerPool()
+void initWorkerPool(WorkerPool *pool){
+    *pool = (WorkerPool){.count = 1};
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutex_init(&pool->busy, NULL);
+    pthread_cond_init(&pool->taskReady, NULL);
+    pthread_cond_init(&pool->taskDone, NULL);
+}
+
+// Start count - 1 workers, the caller is the first one
+void startWorkerPool(WorkerPool *pool, int count){
+    stopWorkerPool(pool);
+    pthread_mutex_lock(&pool->busy);
+    pool->count = count < 1 ? 1 : (count > MAX_WORKERS ? MAX_WORKERS : count);
+    pool->stopping = 0;
+    if(pool->count > 1){
+        pool->firstTask = pool->taskNumber; // Read by the workers after pthread_create()
+        pool->threads = malloc(sizeof(*pool->threads) * pool->count);
+        pool->seats = malloc(sizeof(*pool->seats) * pool->count);
+        if(pool->threads == NULL || pool->seats == NULL){
+            printf("\nERROR: startWorkerPool() function => not enough memory\n");
+            exit(1);
+        }
+        for(int k = 1; k < pool->count; ++k){
+            pool->seats[k] = (WorkerSeat){pool, k};
+            if(pthread_create(&pool->threads[k], NULL, workerLoop, &pool->seats[k]) != 0){
+                printf("\nERROR: startWorkerPool() function => cannot create worker %d\n", k);
+                exit(1);
+            }
+        }
+    }
+    pthread_mutex_unlock(&pool->busy);
+}
+
+void stopWorkerPool(WorkerPool *pool){
+    pthread_mutex_lock(&pool->busy);
+    if(pool->threads != NULL){
+        pthread_mutex_lock(&pool->lock);
+        pool->stopping = 1;
+        pthread_cond_broadcast(&pool->taskReady);
+        pthread_mutex_unlock(&pool->lock);
+        for(int k = 1; k < pool->count; ++k){
+            pthread_join(pool->threads[k], NULL);
+        }
+        free(pool->threads);
+        free(pool->seats);
+        pool->threads = NULL;
+        pool->seats = NULL;
+    }
+    pool->count = 1;
+    pthread_mutex_unlock(&pool->busy);
+}
+
+// Stop the workers and release what initWorkerPool() created
+void freeWorkerPool(WorkerPool *pool){
+    stopWorkerPool(pool);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->busy);
+    pthread_cond_destroy(&pool->taskReady);
+    pthread_cond_destroy(&pool->taskDone);
+}
+
+// Split rows in bands, run task on every band and wait for all of them
+void runWorkerPool(WorkerPool *pool, BandTask task, int rows, void *arg){
+    pthread_mutex_lock(&pool->busy);
+    pool->task = task;
+    pool->arg = arg;
+    pool->rows = rows;
+    if(pool->count == 1){
+        runBand(pool, 0);
+        pthread_mutex_unlock(&pool->busy);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending = pool->count - 1;
+    pool->taskNumber++;
+    pthread_cond_broadcast(&pool->taskReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    runBand(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->pending > 0){
+        pthread_cond_wait(&pool->taskDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->busy);
+}
+
+// Rows [startRow, endRow) of a band, bands start on a tile boundary so a tiled grid is split in contiguous memory
+void workerBandRows(const WorkerPool *pool, int band, int rows, int *startRow, int *endRow){
+    int tileRows = (rows + TILE_MASK) >> TILE_SHIFT;
+    int start = (int)((long long)tileRows * band / pool->count) << TILE_SHIFT;
+    int end = (int)((long long)tileRows * (band + 1) / pool->count) << TILE_SHIFT;
+    *startRow = start < rows ? start : rows;
+    *endRow = end < rows ? end : rows;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Pool of the program ~~~~~~~~~~~~~~~~~~~~~~~ //
+
+WorkerPool *programPool(){
+    return &program;
+}
+
+void startWorkers(int count){
+    startWorkerPool(&program, count);
+}
+
+void stopWorkers(){
+    stopWorkerPool(&program);
+}
+
+int workerCount(){
+    return program.count;
+}
+
+void runWorkers(BandTask task, int rows, void *arg){
+    runWorkerPool(&program, task, rows, arg);
+}
+
+int defaultThreadCount(){
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
@@ -0,0 +1,55 @@
+/*
+    Description:
+        Pools of worker threads used by the multithreaded engine. The rows of a map are split in bands of whole
+        tiles, band k is always given to worker k: the worker that first touches the rows of a grid (see
+        clearGrid()) is the one that computes them, so on a NUMA machine the pages stay on its node.
+
+        Every simulation can own a pool (see life.h); the functions without a pool argument use the pool of the
+        program, which the interactive program, the soup helper and the tools share. The grid helpers take the
+        pool of the simulation that owns the grid, so two handles never run on each other's workers. A pool
+        runs one task at a time: concurrent callers of runWorkerPool() wait for each other instead of mixing
+        their bands.
+*/
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <pthread.h>
+
+#define MAX_WORKERS 256
+
+typedef void (*BandTask)(int band, int startRow, int endRow, void *arg);
+
+typedef struct WorkerPool{
+    pthread_t *threads;    // Workers 1 to count - 1, the caller of runWorkerPool() is worker 0
+    struct WorkerSeat *seats; // Pool and band of every worker thread
+    int count;
+    pthread_mutex_t lock;
+    pthread_mutex_t busy;  // Held for a whole task
+    pthread_cond_t taskReady;
+    pthread_cond_t taskDone;
+    BandTask task;
+    void *arg;
+    int rows;
+    unsigned long taskNumber; // Incremented for every task
+    unsigned long firstTask;  // Task number when the workers were started, older tasks are done
+    int pending;              // Workers still running the current task
+    int stopping;
+} WorkerPool;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~ Functions Prototypes ~~~~~~~~~~~~~~~~~~~~~~~ //
+void initWorkerPool(WorkerPool *pool);
+void startWorkerPool(WorkerPool *pool, int count);
+void stopWorkerPool(WorkerPool *pool);
+void freeWorkerPool(WorkerPool *pool);
+void runWorkerPool(WorkerPool *pool, BandTask task, int rows, void *arg);
+void workerBandRows(const WorkerPool *pool, int band, int rows, int *startRow, int *endRow);
+
+WorkerPool *programPool();
+void startWorkers(int count);
+void stopWorkers();
+int workerCount();
+void runWorkers(BandTask task, int rows, void *arg);
+int defaultThreadCount();
+
+#endif